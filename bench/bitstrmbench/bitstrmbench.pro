@@ -0,0 +1,15 @@
+TEMPLATE = app
+
+# utils.h needs the Qt headers, but nothing from Qt is linked
+QT += widgets
+
+CONFIG += console c++11 release
+CONFIG -= app_bundle debug
+
+SOURCES += \
+    ../../xstoolslib/bitstrm.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../xstoolslib/bitstrm.h \
+    ../../xstoolslib/utils.h
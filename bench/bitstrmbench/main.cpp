@@ -0,0 +1,63 @@
+// Measure how fast Bitstream objects are constructed, copied and destroyed.
+// To compare with the heap-only Bitstream, build this again with bitstrm.cpp and bitstrm.h
+// checked out from before short bitstreams were stored inside the object.
+
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+#include "../../xstoolslib/bitstrm.h"
+
+
+// utils.cpp holds this table along with code that needs the rest of the library,
+// so the benchmark builds its own copy for bitstrm.cpp.
+#define R2(n)	n, n+2*64, n+1*64, n+3*64
+#define R4(n)	R2(n), R2(n+2*16), R2(n+1*16), R2(n+3*16)
+#define R6(n)	R4(n), R4(n+2*4), R4(n+1*4), R4(n+3*4)
+extern const unsigned char reverseByteBits[] = { R6(0), R6(2), R6(1), R6(3) };
+
+static const unsigned long numLoops = 10000000;	// operations timed for each figure
+static volatile unsigned long sink;				// keeps the compiler from dropping the work
+
+
+// Time an operation and report the number of operations per second.
+template<class Op> static void Measure(const char* desc, Op op)
+{
+	unsigned long total = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(unsigned long i=0; i<numLoops; i++)
+		total += op();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	sink = total;
+	cout << desc << ": " << (numLoops / seconds) / 1.0e6 << " M/s" << endl;
+}
+
+
+int main(void)
+{
+	// the empty, IR-sized and IDCODE-sized bitstreams that the JTAG port makes for each operation
+	Measure("construct and destroy 0, 6 and 32 bits", []()
+	{
+		Bitstream null(0), ir(6), id(32);
+		return null.GetLength() + ir.GetLength() + id.GetLength();
+	});
+
+	// a bitstream longer than the inline storage
+	Bitstream dr(200);
+	Measure("copy-construct 200 bits", [&dr]()
+	{
+		Bitstream copy(dr);
+		return copy.GetLength();
+	});
+
+	// a bitstream short enough to be stored inline
+	Bitstream ir(6);
+	Measure("copy-construct 6 bits", [&ir]()
+	{
+		Bitstream copy(ir);
+		return copy.GetLength();
+	});
+
+	return 0;
+}
@@ -0,0 +1,17 @@
+TEMPLATE = app
+
+# utils.h needs the Qt headers, but nothing from Qt is linked
+QT += widgets
+
+CONFIG += console c++11 release
+CONFIG -= app_bundle debug
+
+SOURCES += \
+    ../../xstoolslib/hex.cpp \
+    ../../xstoolslib/hexrecrd.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../xstoolslib/hex.h \
+    ../../xstoolslib/hexrecrd.h \
+    ../../xstoolslib/utils.h
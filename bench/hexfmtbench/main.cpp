@@ -0,0 +1,233 @@
+// Check that hex records are formatted exactly as the iostream manipulator formatter did,
+// and time both formatters on 16 MB of data in every hex file format.
+
+#include <cassert>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+#include "../../xstoolslib/hexrecrd.h"
+#include "../../xstoolslib/utils.h"
+
+
+// utils.cpp holds these along with code that needs the rest of the library.
+// Only the hex record parser uses them, and the benchmark doesn't parse anything.
+unsigned int CharToHex(char c)
+{
+	assert(1==0);
+	return 0;
+}
+
+long unsigned int GetInteger(istream& is, int len)
+{
+	assert(1==0);
+	return 0;
+}
+
+bool ScanForField(istream& is, unsigned char searchType)
+{
+	assert(1==0);
+	return false;
+}
+
+
+static const unsigned int numBenchBytes = 16 << 20;	// bytes formatted for each timing
+static const unsigned int benchRecordLength = 16;	// data bytes in each record of the timing
+
+
+// The hex record formatter as it was before records were built in a character buffer.
+static ostream& OldFormat(ostream& os, HexRecord& hx)
+{
+	if(!hx.IsValid())
+		return os;	// abort if hex record is not valid
+
+	unsigned int i;
+
+	switch(hx.GetFileFormat())
+	{
+	case MotorolaFormat:
+		os << "S";
+		switch(hx.GetRecordType())
+		{
+			case MotoDataWith16BitAddressRecord:
+				os << '1';
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+3;
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetAddress();
+				break;
+			case MotoDataWith24BitAddressRecord:
+				os << '2';
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+4;
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(6) << hex << hx.GetAddress();
+				break;
+			case MotoDataWith32BitAddressRecord:
+				os << '3';
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+5;
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(8) << hex << hx.GetAddress();
+				break;
+			case MotoEndWith16BitAddressRecord:
+				os << '9';
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+3;
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetAddress();
+				break;
+			case MotoEndWith24BitAddressRecord:
+				os << '8';
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+4;
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(6) << hex << hx.GetAddress();
+				break;
+			case MotoEndWith32BitAddressRecord:
+				os << '7';
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+5;
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(8) << hex << hx.GetAddress();
+				break;
+			case MotoStartRecord:
+				os << '0';
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+3;
+				os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetAddress();
+				break;
+			default:
+				assert(1==0);
+				break;
+		}
+		for(i=0; i<hx.GetLength(); i++)
+			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx[i];
+		os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx.GetCheckSum();
+		os << endl;
+		break;
+
+	case IntelFormat:
+		if(hx.IsData())
+		{
+			unsigned int base, offset;
+			base = hx.GetBaseAddress();
+			offset = hx.GetOffsetAddress();
+			if(base != (offset&~0xFFFF))
+			{
+				base = offset & ~0xFFFF;
+				HexRecord h;
+				h.Setup("HEX");
+				h.SetRecordType(IntelExtLinAddressRecord);
+				h.SetLength(2);
+				h.SetOffsetAddress(0);
+				h[0] = (base>>24) & 0xFF;
+				h[1] = (base>>16) & 0xFF;
+				h.CalcCheckSum();
+				OldFormat(os,h);
+			}
+			hx.SetBaseAddress(offset & ~0xFFFF);
+			hx.SetOffsetAddress(offset & 0xFFFF);
+		}
+		os << ":";
+		os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength();
+		os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetOffsetAddress();
+		os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (hx.GetRecordType() & 0x0F);
+		for(i=0; i<hx.GetLength(); i++)
+			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx[i];
+		os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx.GetCheckSum();
+		os << endl;
+		break;
+
+	case XESSFormat:
+		switch(hx.GetRecordType())
+		{
+		case XESSDataWith16BitAddressRecord:
+			os << "- ";
+			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength();
+			os << " ";
+			os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetAddress();
+			break;
+		case XESSDataWith24BitAddressRecord:
+			os << "= ";
+			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength();
+			os << " ";
+			os << setiosflags(ios::uppercase) << setfill('0') << setw(6) << hex << hx.GetAddress();
+			break;
+		case XESSDataWith32BitAddressRecord:
+			os << "+ ";
+			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength();
+			os << " ";
+			os << setiosflags(ios::uppercase) << setfill('0') << setw(8) << hex << hx.GetAddress();
+			break;
+		}
+		for(i=0; i<hx.GetLength(); i++)
+			os << " " << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx[i];
+		os << endl;
+		break;
+
+	default:
+		assert(1==0);
+	}
+
+	return os;
+}
+
+
+// Fill a hex record with data that depends on its address.
+static void FillRecord(HexRecord& hx, unsigned int address, unsigned int length)
+{
+	hx.SetAddress(address);
+	hx.SetLength(length);
+	for(unsigned int i=0; i<length; i++)
+		hx[i] = (address*31 + i*7) & 0xFF;
+	hx.CalcCheckSum();
+}
+
+
+// Format records of varying lengths and addresses with both formatters and compare the text.
+///\return true if the text is the same.
+static bool SameOutput(const char* format)
+{
+	ostringstream oldText, newText;
+	HexRecord oldHx, newHx;	// the Intel formatter keeps the base address in the record
+	oldHx.Setup(format);
+	newHx.Setup(format);
+	for(unsigned int address=0; address<0x30000; address+=0x10+address%7)
+	{
+		unsigned int length = 1 + (address*13)%16;
+		FillRecord(oldHx,address,length);
+		FillRecord(newHx,address,length);
+		OldFormat(oldText,oldHx);
+		newText << newHx;
+	}
+	return oldText.str() == newText.str();
+}
+
+
+// Format numBenchBytes of data with one of the formatters.
+///\return the number of seconds it took.
+static double TimeFormat(const char* format, bool useOld)
+{
+	ostringstream os;
+	HexRecord hx;
+	hx.Setup(format);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(unsigned int address=0; address<numBenchBytes; address+=benchRecordLength)
+	{
+		FillRecord(hx,address,benchRecordLength);
+		if(useOld)
+			OldFormat(os,hx);
+		else
+			os << hx;
+	}
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+int main(void)
+{
+	const char* formats[] = {"XESS-16", "XESS-24", "XESS-32", "EXO-16", "EXO-24", "EXO-32", "MCS", "HEX"};
+	bool allSame = true;
+
+	for(unsigned int f=0; f<sizeof(formats)/sizeof(formats[0]); f++)
+	{
+		bool same = SameOutput(formats[f]);
+		allSame = allSame && same;
+		double oldSeconds = TimeFormat(formats[f],true);
+		double newSeconds = TimeFormat(formats[f],false);
+		cout << setw(8) << left << formats[f] << right << (same ? " same output" : " DIFFERENT OUTPUT")
+			<< fixed << setprecision(3) << ", old " << oldSeconds << " s, new " << newSeconds << " s" << endl;
+	}
+	return allSame ? 0 : 1;
+}
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <strstream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <unistd.h>
 
@@ -34,6 +35,14 @@ GxsloadDlg::GxsloadDlg(QWidget *parent)
 {
     ui->setupUi(this);
 
+    brdPtr = NULL;
+
+    // board operations run on the I/O thread and report back when the queue is empty
+    ioThread = new IOThread(this);
+    connect(ioThread, SIGNAL(AllJobsFinished()), this, SLOT(IOJobsFinished()));
+    connect(ioThread, SIGNAL(JobFinished(int,bool)), this, SLOT(IOJobFinished(int,bool)));
+    uploadJobId = -1;
+
     qApp->installEventFilter(this);
 
     this->setFocusPolicy(Qt::StrongFocus);
@@ -113,6 +122,7 @@ GxsloadDlg::GxsloadDlg(QWidget *parent)
             ui->m_flashFormat->addItem("XESS-16");
             ui->m_flashFormat->addItem("XESS-24");
             ui->m_flashFormat->addItem("XESS-32");
+            ui->m_flashFormat->addItem("BIN");
 
             // setup the list of Flash file formats in the pulldown list
             ui->m_ramFormat->addItem("HEX");
@@ -123,6 +133,7 @@ GxsloadDlg::GxsloadDlg(QWidget *parent)
             ui->m_ramFormat->addItem("XESS-16");
             ui->m_ramFormat->addItem("XESS-24");
             ui->m_ramFormat->addItem("XESS-32");
+            ui->m_ramFormat->addItem("BIN");
 
             ui->m_flashIntfcDownload->setChecked(true);
 
@@ -169,9 +180,25 @@ GxsloadDlg::GxsloadDlg(QWidget *parent)
 
 GxsloadDlg::~GxsloadDlg()
 {
+    delete ioThread;    // waits for the running job to finish
     delete ui;
 }
 
+void GxsloadDlg::closeEvent(QCloseEvent *event)
+{
+    // the running job may be waiting on a dialog, so don't tear down the window underneath it
+    if (ioThread->IsBusy())
+    {
+        ioThread->Cancel();
+        QMessageBox::information(this, "Information", "Wait for the current operation to finish.", QMessageBox::Ok);
+        event->ignore();
+    }
+    else
+    {
+        event->accept();
+    }
+}
+
 bool GxsloadDlg::eventFilter(QObject *obj, QEvent *event)
 {
     if (event->type() == QEvent::KeyPress)
@@ -199,7 +226,38 @@ void GxsloadDlg::keyPressEvent(QKeyEvent *event)
 
 void GxsloadDlg::UpdateLoadButton()
 {
-    ui->m_btnLoad->setEnabled(0 < (SelFPLD + SelNON + SelRAM));
+    ui->m_btnLoad->setEnabled(0 < (SelFPLD + SelNON + SelRAM) && !ioThread->IsBusy());
+}
+
+// Show the summary of the last RAM or Flash transfer of a board in the status bar.
+// This is called on the I/O thread, so the message is queued for the GUI thread.
+static void ShowTransferSummary(QStatusBar *statusbar, XSBoard *brd)
+{
+    string summary = brd->GetTransferSummary();
+    if ("" != summary)
+    {
+        QMetaObject::invokeMethod(statusbar, "showMessage", Qt::QueuedConnection, Q_ARG(QString, QString(summary.c_str())));
+    }
+}
+
+// Called on the GUI thread when the I/O thread has run all the queued board operations.
+void GxsloadDlg::IOJobsFinished()
+{
+    UpdateLoadButton();
+}
+
+// Called on the GUI thread when the I/O thread has run a board operation.
+void GxsloadDlg::IOJobFinished(int id, bool status)
+{
+    // the download jobs ask the user about their own errors, but an upload just ends
+    if (id == uploadJobId)
+    {
+        uploadJobId = -1;
+        if (!status)
+        {
+            QMessageBox::critical(this, "Error", "An error occurred while uploading from the board!", QMessageBox::Ok);
+        }
+    }
 }
 
 void GxsloadDlg::SelUpdatedFPLD(const QString& Count)
@@ -232,39 +290,69 @@ bool GxsloadDlg::ExtractScreenSettings()
 
     Valid = false;
 
-    if (brdPtr != NULL)
+    // the board can't be replaced while the I/O thread is using it
+    if (ioThread->IsBusy())
     {
-        delete brdPtr;
-        brdPtr = NULL;
+        return false;
     }
 
     // get the port type and number
     GuiTools::GetPortTypeAndNumber(ui->m_cmbLpt, &portType, &portNum);
 
-    // determine the type of XS Board and set the pointer to the board object
+    // The board is replaced and set up on the I/O thread because port access is only
+    // granted to the thread that asks for it, and that thread will use the board.
     string brdModel= Parameters::GetXSTOOLSParameter("BoardType");
-    if ("" != brdModel)
+    XSBoard *oldBrd = brdPtr;
+    bool Known = false;
+    brdPtr = NULL;
+    Valid = ioThread->Run([&](const std::atomic<bool>& cancelled)
     {
+        delete oldBrd;
+
+        // determine the type of XS Board and set the pointer to the board object
+        if ("" == brdModel)
+        {
+            return false;
+        }
         brdPtr = NewXSBoard(brdModel.c_str(), portType);
         if (NULL == brdPtr)
         {
-            QMessageBox::critical(this, "Error", "Unknown type of XS Board!", QMessageBox::Ok);
+            return false;
         }
-        else
+        Known = true;
+        if (!brdPtr->Setup(errMsg_ptr, brdModel.c_str(), portNum))
         {
-            Valid = brdPtr->Setup(errMsg_ptr, brdModel.c_str(), portNum);
-            if (!Valid)
-            {
-                string Msg;
+            delete brdPtr;
+            brdPtr = NULL;
+            return false;
+        }
+        return true;
+    });
 
-                Msg = "Invalid port selected!";
-                QMessageBox::critical(this, "Error", Msg.c_str(), QMessageBox::Ok);
+    if ("" != brdModel)
+    {
+        if (!Known)
+        {
+            QMessageBox::critical(this, "Error", "Unknown type of XS Board!", QMessageBox::Ok);
+        }
+        else if (!Valid)
+        {
+            string Msg;
 
-                delete brdPtr;
-                brdPtr = NULL;
-            }
+            Msg = "Invalid port selected!";
+            QMessageBox::critical(this, "Error", Msg.c_str(), QMessageBox::Ok);
         }
     }
+
+    // show how fast the parallel port registers can be accessed
+    if (Valid && PORTTYPE_LPT == portType && PPort::GetThroughput(portNum) > 0)
+    {
+        ui->statusbar->showMessage(QString("LPT%1: %2 register accesses/second").arg(portNum).arg((qulonglong)PPort::GetThroughput(portNum)));
+    }
+    else
+    {
+        ui->statusbar->clearMessage();
+    }
     return Valid;
 }
 
@@ -320,7 +408,6 @@ void GxsloadDlg::OnLoad()
 
 void GxsloadDlg::DownloadSelectedFiles(void)
 {
-    XSError errMsg(cerr); // setup error channel
     QStringList *SelectedFPLD;
     QStringList *SelectedRAM;
     QStringList *SelectedNONVOL;
@@ -335,137 +422,116 @@ void GxsloadDlg::DownloadSelectedFiles(void)
         // get the port type and number
         if (ExtractScreenSettings())
         {
+            // The jobs share the board and it is deleted when the last of them is done or dropped.
+            shared_ptr<XSBoard> brd(brdPtr);
+            brdPtr = NULL;
+
             // if any files in the RAM list are selected, then download them into RAM
             if (0 != SelectedRAM->count())
             {
-                bool ramIntfcDownload;
-                bool UserCancelled;
-                bool FirstFile;
-                int LastFile;
-                int i;
-                string FormatName;
-
-                FormatName = ui->m_ramFormat->itemText(ui->m_ramFormat->currentIndex()).toStdString();
-                ramIntfcDownload = ui->m_ramIntfcDownload->isChecked();
-
-                FirstFile = true;
-                LastFile = SelectedRAM->count() - 1;
-                i = 0;
-                UserCancelled = false;
-                while (!UserCancelled && (i < SelectedRAM->count()))
-                {
-                    string dirAndFileName;
+                QStringList files = *SelectedRAM;
+                bool ramIntfcDownload = ui->m_ramIntfcDownload->isChecked();
+                QStatusBar *statusbar = ui->statusbar;
 
-                    dirAndFileName = SelectedRAM->value(i).toStdString();
+                ioThread->Submit([brd, files, ramIntfcDownload, statusbar](const std::atomic<bool>& cancelled)
+                {
+                    XSError errMsg(cerr); // setup error channel
+                    bool UserCancelled;
+                    bool FirstFile;
+                    int LastFile;
+                    int i;
 
-                    if (!brdPtr->DownloadRAM(dirAndFileName.c_str(), ENDIAN_DEFAULTS, ENDIAN_DEFAULTS, FirstFile && ramIntfcDownload, i == LastFile, &UserCancelled))
-                    {
-                        string instructions = "An error occurred while downloading to the RAM\n\nContinue?";
-                        if (GuiTools::PromptUser(instructions, PROMPT_OKCANCEL) == RESPONSE_CANCEL)
-                        {
-                            break;
-                        }
-                    }
-                    else
+                    FirstFile = true;
+                    LastFile = files.count() - 1;
+                    i = 0;
+                    UserCancelled = false;
+                    while (!UserCancelled && !cancelled && (i < files.count()))
                     {
-                        if(errMsg.IsError())
+                        string dirAndFileName;
+
+                        dirAndFileName = files.value(i).toStdString();
+
+                        if (!brd->DownloadRAM(dirAndFileName.c_str(), ENDIAN_DEFAULTS, ENDIAN_DEFAULTS, FirstFile && ramIntfcDownload, i == LastFile, &UserCancelled)
+                            || errMsg.IsError())
                         {
                             string instructions = "An error occurred while downloading to the RAM\n\nContinue?";
-                            if (GuiTools::PromptUser(instructions,PROMPT_OKCANCEL) == RESPONSE_CANCEL)
+                            if (GuiTools::PromptUser(instructions, PROMPT_OKCANCEL) == RESPONSE_CANCEL)
                             {
-                                break;
+                                return false;
                             }
                         }
-                    }
-                    FirstFile = false;
-                    i++;
-                }
-            }
-
-            // if any files in the FlashEEPROM list are selected, then download them into Flash/EEPROM
-            if (0 != SelectedNONVOL->count())
-            {
-                bool flashIntfcDownload;
-                bool UserCancelled;
-                bool FirstFile;
-                int LastFile;
-                int i;
-                string FormatName;
-
-                FormatName = ui->m_flashFormat->itemText(ui->m_flashFormat->currentIndex()).toStdString();
-                flashIntfcDownload = ui->m_flashIntfcDownload->isChecked();
-
-                FirstFile = true;
-                LastFile = SelectedNONVOL->count() - 1;
-                UserCancelled = false;
-                i = 0;
-                while (!UserCancelled && (i < SelectedNONVOL->count()))
-                {
-                    string dirAndFileName;
-
-                    dirAndFileName = SelectedNONVOL->value(i).toStdString();
-
-                    if (!brdPtr->DownloadFlash(dirAndFileName.c_str(), ENDIAN_DEFAULTS, ENDIAN_DEFAULTS, FirstFile && flashIntfcDownload, i == LastFile, &UserCancelled))
-                    {
-                        string instructions = "An error occurred while downloading to the Flash\n\nContinue?";
-                        if (GuiTools::PromptUser(instructions,PROMPT_OKCANCEL) == RESPONSE_CANCEL)
-                        {
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        if (errMsg.IsError())
+                        else
                         {
-                            string instructions = "An error occurred while downloading to the Flash\n\nContinue?";
-                            if (GuiTools::PromptUser(instructions,PROMPT_OKCANCEL) == RESPONSE_CANCEL)
-                            {
-                                break;
-                            }
+                            ShowTransferSummary(statusbar, brd.get());
                         }
+                        FirstFile = false;
+                        i++;
                     }
-                    FirstFile = false;
-                    i++;
-                }
+                    return true;
+                });
             }
 
-            // if any file in the FPGA/CPLD list is selected, then download it into RAM
-            if (0 != SelectedFPLD->count() )
+            // if any files in the FlashEEPROM list are selected, then download them into Flash/EEPROM
+            if (0 != SelectedNONVOL->count())
             {
-                int numFiles;
+                QStringList files = *SelectedNONVOL;
+                bool flashIntfcDownload = ui->m_flashIntfcDownload->isChecked();
+                QStatusBar *statusbar = ui->statusbar;
 
-                numFiles = SelectedFPLD->count();
-                if (1 == numFiles)
+                ioThread->Submit([brd, files, flashIntfcDownload, statusbar](const std::atomic<bool>& cancelled)
                 {
+                    XSError errMsg(cerr); // setup error channel
                     bool UserCancelled;
+                    bool FirstFile;
+                    int LastFile;
                     int i;
 
+                    FirstFile = true;
+                    LastFile = files.count() - 1;
                     UserCancelled = false;
                     i = 0;
-                    while (!UserCancelled && (i < SelectedFPLD->count()))
+                    while (!UserCancelled && !cancelled && (i < files.count()))
                     {
                         string dirAndFileName;
 
-                        dirAndFileName = SelectedFPLD->value(i).toStdString();
+                        dirAndFileName = files.value(i).toStdString();
 
-                        if (!brdPtr->Configure(dirAndFileName.c_str(), &UserCancelled))
+                        if (!brd->DownloadFlash(dirAndFileName.c_str(), ENDIAN_DEFAULTS, ENDIAN_DEFAULTS, FirstFile && flashIntfcDownload, i == LastFile, &UserCancelled)
+                            || errMsg.IsError())
                         {
-                            break;
+                            string instructions = "An error occurred while downloading to the Flash\n\nContinue?";
+                            if (GuiTools::PromptUser(instructions,PROMPT_OKCANCEL) == RESPONSE_CANCEL)
+                            {
+                                return false;
+                            }
                         }
                         else
                         {
-                            if (errMsg.IsError())
-                            {
-                                break;
-                            }
+                            ShowTransferSummary(statusbar, brd.get());
                         }
+                        FirstFile = false;
                         i++;
                     }
-                }
+                    return true;
+                });
+            }
+
+            // if any file in the FPGA/CPLD list is selected, then download it into RAM
+            if (1 == SelectedFPLD->count())
+            {
+                string dirAndFileName = SelectedFPLD->value(0).toStdString();
+
+                ioThread->Submit([brd, dirAndFileName](const std::atomic<bool>& cancelled)
+                {
+                    XSError errMsg(cerr); // setup error channel
+                    bool UserCancelled = false;
+
+                    return brd->Configure(dirAndFileName.c_str(), &UserCancelled) && !errMsg.IsError();
+                });
             }
+
+            UpdateLoadButton();
         }
-        delete brdPtr;
-        brdPtr = NULL;
     }
    delete SelectedFPLD;
    delete SelectedRAM;
@@ -497,7 +563,6 @@ bool GxsloadDlg::UploadFile(int Source, string UploadPath)
 {    
     bool status;
     string Msg;
-    bool UserCancelled;
     string formatName;
     string UploadFilename;
     int hiAddress, loAddress;
@@ -513,6 +578,12 @@ bool GxsloadDlg::UploadFile(int Source, string UploadPath)
 
     status = false;
 
+    // one board operation at a time
+    if (ioThread->IsBusy())
+    {
+        return false;
+    }
+
     if (RAMSOURCE == Source)
     {
         // Assume we have good addresses so far
@@ -563,7 +634,23 @@ bool GxsloadDlg::UploadFile(int Source, string UploadPath)
         {
             if (NULL != brdPtr)
             {
-                status = brdPtr->UploadRAM(UploadFilename.c_str(), formatName.c_str(), loAddress, hiAddress, ENDIAN_DEFAULTS, ENDIAN_DEFAULTS, IntfcDownload, true, &UserCancelled);
+                XSBoard *brd = brdPtr;
+                QStatusBar *statusbar = ui->statusbar;
+
+                uploadJobId = ioThread->Submit([brd, UploadFilename, formatName, loAddress, hiAddress, IntfcDownload, statusbar](const std::atomic<bool>& cancelled)
+                {
+                    XSError errMsg(cerr); // setup error channel
+                    bool UserCancelled = false;
+
+                    bool status = brd->UploadRAM(UploadFilename.c_str(), formatName.c_str(), loAddress, hiAddress, ENDIAN_DEFAULTS, ENDIAN_DEFAULTS, IntfcDownload, true, &UserCancelled)
+                        && !errMsg.IsError();
+                    if (status)
+                    {
+                        ShowTransferSummary(statusbar, brd);
+                    }
+                    return status;
+                });
+                UpdateLoadButton();
             }
         }
     }
@@ -618,7 +705,23 @@ bool GxsloadDlg::UploadFile(int Source, string UploadPath)
         {
             if (NULL != brdPtr)
             {
-                status = brdPtr->UploadFlash(UploadFilename.c_str(), formatName.c_str(), loAddress, hiAddress, ENDIAN_DEFAULTS, ENDIAN_DEFAULTS, IntfcDownload, true, &UserCancelled);
+                XSBoard *brd = brdPtr;
+                QStatusBar *statusbar = ui->statusbar;
+
+                uploadJobId = ioThread->Submit([brd, UploadFilename, formatName, loAddress, hiAddress, IntfcDownload, statusbar](const std::atomic<bool>& cancelled)
+                {
+                    XSError errMsg(cerr); // setup error channel
+                    bool UserCancelled = false;
+
+                    bool status = brd->UploadFlash(UploadFilename.c_str(), formatName.c_str(), loAddress, hiAddress, ENDIAN_DEFAULTS, ENDIAN_DEFAULTS, IntfcDownload, true, &UserCancelled)
+                        && !errMsg.IsError();
+                    if (status)
+                    {
+                        ShowTransferSummary(statusbar, brd);
+                    }
+                    return status;
+                });
+                UpdateLoadButton();
             }
         }
     }
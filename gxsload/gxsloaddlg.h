@@ -6,6 +6,7 @@
 #include "mylist.h"
 #include "../xstoolslib/xserror.h"
 #include "../xstoolslib/xsboard.h"
+#include "../xstoolslib/iothread.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class GxsloadDlg; }
@@ -28,6 +29,8 @@ private slots:
     void SelUpdatedNON(const QString&);
     void UploadData(const QString&);
     void DownloadSelectedFiles();
+    void IOJobsFinished();
+    void IOJobFinished(int id, bool status);
 
 public:
     GxsloadDlg(QWidget *parent = nullptr);
@@ -45,11 +48,16 @@ private:
     PortType portType;
     int portNum;
 
+    IOThread *ioThread;     ///< runs the board operations so the GUI stays responsive
+    int uploadJobId;        ///< id of the upload job whose result hasn't been reported, or -1
+
 private:
     bool eventFilter(QObject *obj, QEvent *event);
 
     void keyPressEvent(QKeyEvent *event);
 
+    void closeEvent(QCloseEvent *event);
+
     bool ExtractScreenSettings();
 
     void UpdateLoadButton();
@@ -2,8 +2,23 @@
 
 #include <QApplication>
 
+#include <cstring>
+#include <iostream>
+
+#include "../xstoolslib/svfprog.h"
+
 int main(int argc, char *argv[])
 {
+    // "gxsload --svfcache <dir>" compiles every SVF file under <dir> (e.g. XessData)
+    // into its cache file so later downloads don't have to parse them.
+    if ((3 == argc) && (0 == strcmp(argv[1], "--svfcache")))
+    {
+        XSError err(cerr);
+        unsigned int numCompiled = SVFProgram::CompileTree(argv[2], err, cout);
+        cout << numCompiled << " SVF files compiled\n";
+        return err.IsError() ? 1 : 0;
+    }
+
     QApplication a(argc, argv);
     GxsloadDlg w;
     w.show();
@@ -161,6 +161,16 @@ bool gxsportDlg::ExtractScreenSettings()
             }
         }
     }
+
+    // show how fast the parallel port registers can be accessed
+    if (Valid && PORTTYPE_LPT == portType && PPort::GetThroughput(portNum) > 0)
+    {
+        ui->statusbar->showMessage(QString("LPT%1: %2 register accesses/second").arg(portNum).arg((qulonglong)PPort::GetThroughput(portNum)));
+    }
+    else
+    {
+        ui->statusbar->clearMessage();
+    }
     return Valid;
 }
 
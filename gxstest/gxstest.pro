@@ -16,14 +16,17 @@ SOURCES += \
     ../xstoolslib/at49fprt.cpp \
     ../xstoolslib/bitstrm.cpp \
     ../xstoolslib/cnfgport.cpp \
+    ../xstoolslib/delaytmr.cpp \
     ../xstoolslib/f28port.cpp \
     ../xstoolslib/flashprt.cpp \
     ../xstoolslib/guitools.cpp \
     ../xstoolslib/hex.cpp \
+    ../xstoolslib/heximage.cpp \
     ../xstoolslib/hexrecrd.cpp \
     ../xstoolslib/i2cport.cpp \
     ../xstoolslib/i2cportlpt.cpp \
     ../xstoolslib/io.cpp \
+    ../xstoolslib/iothread.cpp \
     ../xstoolslib/jramprt.cpp \
     ../xstoolslib/jtagport.cpp \
     ../xstoolslib/lptjtag.cpp \
@@ -37,9 +40,12 @@ SOURCES += \
     ../xstoolslib/progress.cpp \
     ../xstoolslib/ramport.cpp \
     ../xstoolslib/saa711x.cpp \
+    ../xstoolslib/svfprog.cpp \
+    ../xstoolslib/svfread.cpp \
     ../xstoolslib/testport.cpp \
     ../xstoolslib/transport.cpp \
     ../xstoolslib/transports.cpp \
+    ../xstoolslib/uploadpipe.cpp \
     ../xstoolslib/utils.cpp \
     ../xstoolslib/xc3sprt.cpp \
     ../xstoolslib/xc95kprt.cpp \
@@ -65,15 +71,18 @@ HEADERS += \
     ../xstoolslib/at49fprt.h \
     ../xstoolslib/bitstrm.h \
     ../xstoolslib/cnfgport.h \
+    ../xstoolslib/delaytmr.h \
     ../xstoolslib/eeprom_flags.h \
     ../xstoolslib/f28port.h \
     ../xstoolslib/flashprt.h \
     ../xstoolslib/guitools.h \
     ../xstoolslib/hex.h \
+    ../xstoolslib/heximage.h \
     ../xstoolslib/hexrecrd.h \
     ../xstoolslib/i2cport.h \
     ../xstoolslib/i2cportlpt.h \
     ../xstoolslib/io.h \
+    ../xstoolslib/iothread.h \
     ../xstoolslib/jramprt.h \
     ../xstoolslib/jtaginstr.h \
     ../xstoolslib/jtagport.h \
@@ -87,9 +96,12 @@ HEADERS += \
     ../xstoolslib/progress.h \
     ../xstoolslib/ramport.h \
     ../xstoolslib/saa711x.h \
+    ../xstoolslib/svfprog.h \
+    ../xstoolslib/svfread.h \
     ../xstoolslib/testport.h \
     ../xstoolslib/transport.h \
     ../xstoolslib/transports.h \
+    ../xstoolslib/uploadpipe.h \
     ../xstoolslib/usbcmd.h \
     ../xstoolslib/utils.h \
     ../xstoolslib/xc3sprt.h \
@@ -29,6 +29,12 @@ gxsTestDlg::gxsTestDlg(QWidget *parent)
 {
     ui->setupUi(this);
 
+    brdPtr = NULL;
+
+    // the board test runs on the I/O thread and reports back when it is done
+    ioThread = new IOThread(this);
+    connect(ioThread, SIGNAL(AllJobsFinished()), this, SLOT(IOJobsFinished()));
+
     connect(ui->buttonBox->button(QDialogButtonBox::Cancel), SIGNAL(clicked()), SLOT(CancelButton_clicked()));
     connect(ui->ButtonTest, SIGNAL(clicked()), SLOT(OnTest()));
     connect(ui->m_cmbLpt, SIGNAL(currentIndexChanged(const QString&)), SLOT(OnSelchangeComboLpt(const QString&)));
@@ -100,46 +106,81 @@ gxsTestDlg::gxsTestDlg(QWidget *parent)
 
 gxsTestDlg::~gxsTestDlg()
 {
+    delete ioThread;    // waits for the running test to finish
     delete ui;
 }
 
+void gxsTestDlg::closeEvent(QCloseEvent *event)
+{
+    // the running test may be waiting on a dialog, so don't tear down the window underneath it
+    if (ioThread->IsBusy())
+    {
+        QMessageBox::information(this, "Information", "Wait for the board test to finish.", QMessageBox::Ok);
+        event->ignore();
+    }
+    else
+    {
+        event->accept();
+    }
+}
+
 bool gxsTestDlg::ExtractScreenSettings()
 {
     bool Valid;
 
     Valid = false;
 
-    if (brdPtr != NULL)
+    // the board can't be replaced while the I/O thread is testing it
+    if (ioThread->IsBusy())
     {
-        delete brdPtr;
-        brdPtr = NULL;
+        return false;
     }
 
     // get the port type and number
     GuiTools::GetPortTypeAndNumber(ui->m_cmbLpt, &portType, &portNum);
 
-    // determine the type of XS Board and set the pointer to the board object
+    // The board is replaced and set up on the I/O thread because port access is only
+    // granted to the thread that asks for it, and that thread will use the board.
     string brdModel= Parameters::GetXSTOOLSParameter("BoardType");
-    if ("" != brdModel)
+    XSBoard *oldBrd = brdPtr;
+    bool Known = false;
+    brdPtr = NULL;
+    Valid = ioThread->Run([&](const std::atomic<bool>& cancelled)
     {
+        delete oldBrd;
+
+        // determine the type of XS Board and set the pointer to the board object
+        if ("" == brdModel)
+        {
+            return false;
+        }
         brdPtr = NewXSBoard(brdModel.c_str(), portType);
         if (NULL == brdPtr)
         {
-            QMessageBox::critical(this, "Error", "Unknown type of XS Board!", QMessageBox::Ok);
+            return false;
         }
-        else
+        Known = true;
+        if (!brdPtr->Setup(errMsg_ptr, brdModel.c_str(), portNum))
         {
-            Valid = brdPtr->Setup(errMsg_ptr, brdModel.c_str(), portNum);
-            if (!Valid)
-            {
-                string Msg;
+            delete brdPtr;
+            brdPtr = NULL;
+            return false;
+        }
+        return true;
+    });
 
-                Msg = "Invalid port selected!";
-                QMessageBox::critical(this, "Error", Msg.c_str(), QMessageBox::Ok);
+    if ("" != brdModel)
+    {
+        if (!Known)
+        {
+            QMessageBox::critical(this, "Error", "Unknown type of XS Board!", QMessageBox::Ok);
+        }
+        else if (!Valid)
+        {
+            string Msg;
 
-                delete brdPtr;
-                brdPtr = NULL;
-            }
+            Msg = "Invalid port selected!";
+            QMessageBox::critical(this, "Error", Msg.c_str(), QMessageBox::Ok);
         }
     }
     return Valid;
@@ -181,11 +222,24 @@ void gxsTestDlg::OnTest()
 
     if (NULL != brdPtr)
     {
-        brdPtr->Test();
-
-        delete brdPtr;
+        XSBoard *brd = brdPtr;
         brdPtr = NULL;
+
+        ui->ButtonTest->setEnabled(false);
+        ioThread->Submit([brd](const std::atomic<bool>& cancelled)
+        {
+            bool status = brd->Test();
+
+            delete brd;
+            return status;
+        });
     }
 }
 
+// Called on the GUI thread when the I/O thread has finished the board test.
+void gxsTestDlg::IOJobsFinished()
+{
+    ui->ButtonTest->setEnabled(true);
+}
+
 
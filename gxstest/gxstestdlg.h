@@ -5,6 +5,7 @@
 
 #include "../xstoolslib/xserror.h"
 #include "../xstoolslib/xsboard.h"
+#include "../xstoolslib/iothread.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class gxsTestDlg; }
@@ -19,6 +20,7 @@ private slots:
     void OnSelchangeComboLpt(const QString& index);
     void OnSelchangeCmbBoard(const QString& index);
     void OnTest();
+    void IOJobsFinished();
 
 public:
     gxsTestDlg(QWidget *parent = nullptr);
@@ -33,8 +35,12 @@ private:
     PortType portType;
     int portNum;
 
+    IOThread *ioThread;     ///< runs the board test so the GUI stays responsive
+
 private:
     bool ExtractScreenSettings();
 
+    void closeEvent(QCloseEvent *event);
+
 };
 #endif // GXSTESTDLG_H
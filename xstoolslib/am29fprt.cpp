@@ -19,6 +19,7 @@
 
 
 #include <fstream>
+#include <algorithm>
 #include <cassert>
 
 #include "utils.h"
@@ -28,7 +29,7 @@
 /// Create a Flash upload/download port.
 AM29FPort::AM29FPort(void)
 {
-	;
+	bypassed = false;
 }
 
 
@@ -46,53 +47,11 @@ AM29FPort::AM29FPort(XSError* e,	///< pointer to error reporting object
 				   unsigned int pos_stmsb)	///< bit position in parallel port of MSB of Flash status pin
 	: FlashPort(e,portNum,invMask,pos_reset,pos_clk,pos_dolsb,pos_domsb,pos_dilsb,pos_dimsb,pos_stlsb,pos_stmsb)
 {
-	;
+	bypassed = false;
 }
 
 
-struct flashBlock
-{
-	unsigned int address; // address of block
-	unsigned int length; // length of block
-	bool erased; // true if block is erase
-} static flashBlocks[] = 
-{
-	{0x00000000, 0x00010000, false},
-	{0x00010000, 0x00010000, false},
-	{0x00020000, 0x00010000, false},
-	{0x00030000, 0x00010000, false},
-	{0x00050000, 0x00010000, false},
-	{0x00060000, 0x00010000, false},
-	{0x00070000, 0x00010000, false},
-	{0x00080000, 0x00010000, false},
-	{0x00090000, 0x00010000, false},
-	{0x000A0000, 0x00010000, false},
-	{0x000B0000, 0x00010000, false},
-	{0x000C0000, 0x00010000, false},
-	{0x000D0000, 0x00010000, false},
-	{0x000E0000, 0x00010000, false},
-	{0x000F0000, 0x00010000, false},
-	{0x00100000, 0x00010000, false},
-	{0x00110000, 0x00010000, false},
-	{0x00120000, 0x00010000, false},
-	{0x00130000, 0x00010000, false},
-	{0x00140000, 0x00010000, false},
-	{0x00150000, 0x00010000, false},
-	{0x00160000, 0x00010000, false},
-	{0x00170000, 0x00010000, false},
-	{0x00180000, 0x00010000, false},
-	{0x00190000, 0x00010000, false},
-	{0x001A0000, 0x00010000, false},
-	{0x001B0000, 0x00010000, false},
-	{0x001C0000, 0x00010000, false},
-	{0x001D0000, 0x00010000, false},
-	{0x001E0000, 0x00010000, false},
-	{0x001F0000, 0x00008000, false},
-	{0x001F8000, 0x00002000, false},
-	{0x001FA000, 0x00002000, false},
-	{0x001FC000, 0x00004000, false},
-};
-
+static const unsigned int erasePollInterval = 100;	// milliseconds between checks for the end of a chip erase
 
 /// Program a byte in the Flash.
 ///\return true if successful, false if not.
@@ -102,11 +61,64 @@ bool AM29FPort::ProgramFlash( unsigned int address,	///< address at which to sto
 					bool bigEndianBits)		///< data is stored in RAM with most-significant bit in position 0
 {
 //	fprintf(stdout,"%02x => (%06x)\n",data,address);
-	if(WriteFlashByte(0xAAA,  0xAA,ENDIAN_DEFAULTS)	== false)	return false;
-	if(WriteFlashByte(0x555,  0x55,ENDIAN_DEFAULTS)	== false)	return false;
+	if(!bypassed)
+	{
+		if(WriteFlashByte(0xAAA,  0xAA,ENDIAN_DEFAULTS)	== false)	return false;
+		if(WriteFlashByte(0x555,  0x55,ENDIAN_DEFAULTS)	== false)	return false;
+	}
 	if(WriteFlashByte(0xAAA,  0xA0,ENDIAN_DEFAULTS)	== false)	return false;
 	if(WriteFlashByte(address,data,bigEndianBytes,bigEndianBits)	== false)	return false;
 
+	return WaitForProgram(address,data,bigEndianBytes,bigEndianBits);
+}
+
+
+/// Program a run of bytes in the Flash through its write buffer.
+/// The bytes must all lie in the same page of the write buffer.
+///\return true if successful, false if not.
+bool AM29FPort::ProgramFlashBuffer( unsigned int address,	///< address at which to store the first byte
+					const unsigned char* data,	///< data bytes to be stored
+					unsigned int length,	///< number of data bytes
+					bool bigEndianBytes,	///< data is stored in RAM with most-significant byte at lower address
+					bool bigEndianBits)		///< data is stored in RAM with most-significant bit in position 0
+{
+	const FlashType* type = GetFlashType();
+	if(!IsFastProgram() || type->writeBufferSize==0)
+		return FlashPort::ProgramFlashBuffer(address,data,length,bigEndianBytes,bigEndianBits);
+	assert(length>0 && length<=type->writeBufferSize);
+
+	if(!bypassed)
+	{
+		if(WriteFlashByte(0xAAA,  0xAA,ENDIAN_DEFAULTS)	== false)	return false;
+		if(WriteFlashByte(0x555,  0x55,ENDIAN_DEFAULTS)	== false)	return false;
+	}
+	if(WriteFlashByte(address,0x25,ENDIAN_DEFAULTS)	== false)	return false;	// load the write buffer of this sector
+	if(WriteFlashByte(address,length-1,ENDIAN_DEFAULTS)	== false)	return false;
+	for(unsigned int i=0; i<length; i++)
+	{
+		if(WriteFlashByte(address+i,data[i],bigEndianBytes,bigEndianBits) == false)	return false;
+	}
+	if(WriteFlashByte(address,0x29,ENDIAN_DEFAULTS)	== false)	return false;	// program the buffer into the sector
+
+	if(WaitForProgram(address+length-1,data[length-1],bigEndianBytes,bigEndianBits) == false)
+	{
+		// clear the write buffer abort so the chip will accept commands again
+		WriteFlashByte(0xAAA,0xAA,ENDIAN_DEFAULTS);
+		WriteFlashByte(0x555,0x55,ENDIAN_DEFAULTS);
+		WriteFlashByte(0xAAA,0xF0,ENDIAN_DEFAULTS);
+		return false;
+	}
+	return true;
+}
+
+
+/// Wait for the Flash to finish programming and check the last byte that was programmed.
+///\return true if the byte holds the right value, false if not.
+bool AM29FPort::WaitForProgram( unsigned int address,	///< address of the last byte that was programmed
+					unsigned int data,		///< value of the last byte that was programmed
+					bool bigEndianBytes,	///< data is stored in RAM with most-significant byte at lower address
+					bool bigEndianBits)		///< data is stored in RAM with most-significant bit in position 0
+{
 	unsigned int d;
 	if(ReadFlashByte(address,&d,ENDIAN_DEFAULTS) == false)
 		return false;
@@ -149,13 +161,14 @@ bool AM29FPort::EraseFlash(void)
     Progress* eraseProgressGauge = new Progress(NULL, NULL);
     if (NULL != eraseProgressGauge)
     {
-        eraseProgressGauge->Setup(desc,subdesc,0,30);
-        status = true;
+        // the progress bar fills over the typical erase time, but the erase ends as soon as the chip says it is done
         const unsigned int estimated_erase_time = 60;  // units = seconds
+        eraseProgressGauge->Setup(desc,subdesc,0,estimated_erase_time*1000);
+        status = true;
         for(i = 0; ; i++)
         {
-            InsertDelay((estimated_erase_time * 1000)/30,MILLISECONDS);
-            eraseProgressGauge->Report(i%30);
+            InsertDelay(erasePollInterval,MILLISECONDS);
+            eraseProgressGauge->Report(min(i*erasePollInterval,estimated_erase_time*1000));
 
             unsigned int d;
             if (ReadFlashByte(0,&d,ENDIAN_DEFAULTS) == false)
@@ -165,19 +178,13 @@ bool AM29FPort::EraseFlash(void)
             }
             if (d & 0x80)
             {
-                break;	// erase is done when MSB is set
+                break;	// erase is done when DQ7 is set
             }
         }
         delete eraseProgressGauge;
         eraseProgressGauge = NULL;
-
-        // initialize the block erasure flags
-        for(i=sizeof(flashBlocks)/sizeof(struct flashBlock)-1; i>=0; i--)
-        {
-            flashBlocks[i].erased = true;
-        }
     }
-	return true;
+	return status;
 }
 
 
@@ -185,8 +192,15 @@ bool AM29FPort::EraseFlash(void)
 ///\return true if successful, false if not.
 bool AM29FPort::EraseFlashBlock(unsigned int blockIndex)
 {
-	assert(blockIndex < sizeof(flashBlocks)/sizeof(struct flashBlock));
-	unsigned int address = flashBlocks[blockIndex].address;
+	unsigned int address, length;
+	if(GetFlashBlock(blockIndex,&address,&length) == false)
+	{
+		XSError& err = GetErr();
+		err.SetSeverity(XSErrorMajor);
+		err << "Flash block " << (long)blockIndex << " doesn't exist in this chip\n";
+		err.EndMsg();
+		return false;
+	}
 	if(WriteFlashByte(0xAAA,  0xAA,ENDIAN_DEFAULTS)	== false)	return false;
 	if(WriteFlashByte(0x555,  0x55,ENDIAN_DEFAULTS)	== false)	return false;
 	if(WriteFlashByte(0xAAA,  0x80,ENDIAN_DEFAULTS)	== false)	return false;
@@ -203,7 +217,6 @@ bool AM29FPort::EraseFlashBlock(unsigned int blockIndex)
 			return false;
 	}
 
-	flashBlocks[blockIndex].erased = true;
 	return true;
 }
 
@@ -214,3 +227,46 @@ bool AM29FPort::ResetFlash(void)
 {
 	return true;
 }
+
+
+/// Read the manufacturer and device codes of the Flash in autoselect mode.
+///\return true if the codes were read, false if not.
+bool AM29FPort::ReadFlashId(unsigned int* manufacturerId,	///< returns the manufacturer code
+					unsigned int* deviceId)	///< returns the device code
+{
+	if(WriteFlashByte(0xAAA,  0xAA,ENDIAN_DEFAULTS)	== false)	return false;
+	if(WriteFlashByte(0x555,  0x55,ENDIAN_DEFAULTS)	== false)	return false;
+	if(WriteFlashByte(0xAAA,  0x90,ENDIAN_DEFAULTS)	== false)	return false;
+	bool status = ReadFlashByte(0x000,manufacturerId,ENDIAN_DEFAULTS)
+				&& ReadFlashByte(0x002,deviceId,ENDIAN_DEFAULTS);
+	if(WriteFlashByte(0x000,  0xF0,ENDIAN_DEFAULTS)	== false)	return false;	// back to reading the array
+	return status;
+}
+
+
+/// Enter unlock bypass mode if the chip supports it, so each byte is programmed with two bus cycles instead of four.
+///\return true if successful, false if not.
+bool AM29FPort::StartProgramming(void)
+{
+	const FlashType* type = GetFlashType();
+	if(bypassed || !IsFastProgram() || !type->unlockBypass)
+		return true;
+	if(WriteFlashByte(0xAAA,  0xAA,ENDIAN_DEFAULTS)	== false)	return false;
+	if(WriteFlashByte(0x555,  0x55,ENDIAN_DEFAULTS)	== false)	return false;
+	if(WriteFlashByte(0xAAA,  0x20,ENDIAN_DEFAULTS)	== false)	return false;
+	bypassed = true;
+	return true;
+}
+
+
+/// Leave unlock bypass mode so the chip will accept erase and autoselect commands again.
+///\return true if successful, false if not.
+bool AM29FPort::EndProgramming(void)
+{
+	if(!bypassed)
+		return true;
+	bypassed = false;
+	if(WriteFlashByte(0x000,  0x90,ENDIAN_DEFAULTS)	== false)	return false;
+	if(WriteFlashByte(0x000,  0x00,ENDIAN_DEFAULTS)	== false)	return false;
+	return true;
+}
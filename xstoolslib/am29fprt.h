@@ -27,7 +27,8 @@
 Uploading and downloading of hexadecimal records to the Spansion Flash memory on XSA-200 and XSA-3S1000 Boards.
 
 This object specializes the FlashPort object by providing methods for erasing blocks and writing 
-individual bytes of a Spansion S29* Flash memory.
+individual bytes of a Spansion S29* Flash memory. Chips that support it are programmed in unlock 
+bypass mode, and chips with a write buffer are loaded a page at a time.
 */
 class AM29FPort : public FlashPort
 {
@@ -58,6 +59,26 @@ class AM29FPort : public FlashPort
 	bool EraseFlashBlock(unsigned int blockIndex);
 
 	bool ResetFlash(void);
+
+	bool ReadFlashId(unsigned int* manufacturerId, unsigned int* deviceId);
+
+	bool StartProgramming(void);
+
+	bool EndProgramming(void);
+
+	bool ProgramFlashBuffer(
+		unsigned int address,
+		const unsigned char* data,
+		unsigned int length,
+		bool bigEndianBytes,
+		bool bigEndianBits);
+
+
+	private:
+
+	bool WaitForProgram(unsigned int address, unsigned int data, bool bigEndianBytes, bool bigEndianBits);
+
+	bool bypassed;	///< true while the chip is in unlock bypass mode
 };
 
 #endif
@@ -19,6 +19,7 @@
 
 
 #include <fstream>
+#include <algorithm>
 #include <cassert>
 
 #include "utils.h"
@@ -50,6 +51,8 @@ AT49FPort::AT49FPort(XSError* e,	///> pointer to error reporting object
 }
 
 
+static const unsigned int erasePollInterval = 100;	// milliseconds between checks for the end of a chip erase
+
 struct flashBlock
 {
 	unsigned int address; // address of block
@@ -119,13 +122,14 @@ bool AT49FPort::EraseFlash(void)
     Progress* eraseProgressGauge = new Progress(NULL, NULL);
     if (NULL != eraseProgressGauge)
     {
-        eraseProgressGauge->Setup(desc, subdesc, 0, 30);
-
+        // the progress bar fills over the typical erase time, but the erase ends as soon as the chip says it is done
         const unsigned int estimated_erase_time = 10;  // units = seconds
+        eraseProgressGauge->Setup(desc, subdesc, 0, estimated_erase_time*1000);
+
         for(i = 0; ; i++)
         {
-            InsertDelay((estimated_erase_time * 1000)/30,MILLISECONDS);
-            eraseProgressGauge->Report(i%30);
+            InsertDelay(erasePollInterval,MILLISECONDS);
+            eraseProgressGauge->Report(min(i*erasePollInterval,estimated_erase_time*1000));
             unsigned int d;
             if(ReadFlashByte(0,&d,ENDIAN_DEFAULTS) == false)
             {
@@ -134,7 +138,7 @@ bool AT49FPort::EraseFlash(void)
             if(d & 0x80)
             {
                 status = true;
-                break;	// erase is done when MSB is set
+                break;	// erase is done when DQ7 is set
             }
         }
         delete eraseProgressGauge;
@@ -177,9 +181,50 @@ bool AT49FPort::EraseFlashBlock(unsigned int blockIndex)
 }
 
 
+/// Get the number of erasable blocks in the Flash.
+///\return the number of blocks.
+unsigned int AT49FPort::GetNumFlashBlocks(void)
+{
+	return sizeof(flashBlocks)/sizeof(struct flashBlock);
+}
+
+
+/// Get the location of an erasable block in the Flash.
+///\return true if the block exists, false if not.
+bool AT49FPort::GetFlashBlock(unsigned int blockIndex,	///< index of Flash block
+					unsigned int* address,	///< returns the address of the first byte in the block
+					unsigned int* length)	///< returns the number of bytes in the block
+{
+	if(blockIndex >= GetNumFlashBlocks())
+		return false;
+	*address = flashBlocks[blockIndex].address;
+	*length = flashBlocks[blockIndex].length;
+	return true;
+}
+
+
 /// Reset the Flash so data can be read from it.
 ///\return true if successful, false if not.
 bool AT49FPort::ResetFlash(void)
 {
 	return true;
 }
+
+
+/// Read the manufacturer and device codes of the Flash in product identification mode.
+/// The AT49F parts have no unlock bypass or write buffer, so this just lets the chip be
+/// found in the table of Flash types.
+///\return true if the codes were read, false if not.
+bool AT49FPort::ReadFlashId(unsigned int* manufacturerId,	///< returns the manufacturer code
+					unsigned int* deviceId)	///< returns the device code
+{
+	if(WriteFlashByte(0x5555,0xAA,ENDIAN_DEFAULTS) == false)	return false;
+	if(WriteFlashByte(0x2AAA,0x55,ENDIAN_DEFAULTS) == false)	return false;
+	if(WriteFlashByte(0x5555,0x90,ENDIAN_DEFAULTS) == false)	return false;
+	bool status = ReadFlashByte(0x0000,manufacturerId,ENDIAN_DEFAULTS)
+				&& ReadFlashByte(0x0001,deviceId,ENDIAN_DEFAULTS);
+	if(WriteFlashByte(0x5555,0xAA,ENDIAN_DEFAULTS) == false)	return false;	// exit product identification mode
+	if(WriteFlashByte(0x2AAA,0x55,ENDIAN_DEFAULTS) == false)	return false;
+	if(WriteFlashByte(0x5555,0xF0,ENDIAN_DEFAULTS) == false)	return false;
+	return status;
+}
@@ -59,7 +59,13 @@ class AT49FPort : public FlashPort
 
 	bool EraseFlashBlock(unsigned int blockIndex);
 
+	unsigned int GetNumFlashBlocks(void);
+
+	bool GetFlashBlock(unsigned int blockIndex, unsigned int* address, unsigned int* length);
+
 	bool ResetFlash(void);
+
+	bool ReadFlashId(unsigned int* manufacturerId, unsigned int* deviceId);
 };
 
 #endif
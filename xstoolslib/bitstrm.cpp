@@ -21,6 +21,7 @@
 #include <cctype>
 #include <cstdarg>
 #include <cassert>
+#include <utility>
 
 #include <string.h>
 
@@ -40,35 +41,52 @@ static const unsigned int bitsPerLong		= 8 * charsPerLong;
 /// Allocates a bitstream containing at least n bits.
 Bitstream::Bitstream(unsigned int n) ///< length of bitstream
 {
-	numBits = n;		// remember number of bits in the bitstream
-    unsigned int numLongs;
-    unsigned int i;
-
-    numLongs = NUM_OF_LONGS(numBits); // number of words to store it
-    bits = new unsigned long[numLongs];	// allocate storage
-    //  make sure storage was allocated
-    if (NULL != bits)
-    {
-        for (i = 0; i < numLongs; i++)
-        {
-            bits[i] = 0;	// clear all bits in stream to 0
-        }
-    }
+	numBits = 0;
+	bits = inlineBits;	// start with the storage inside the object
+	numLongsAllocated = numInlineLongs;
+	Clear();
+	Resize(n);			// only goes to the heap if the bitstream is too big for the object storage
 }
 
 
 /// Allocates a bitstream and initializes it with a bit pattern
 Bitstream::Bitstream(const string s)
 {
-	Bitstream(0);
+	numBits = 0;
+	bits = inlineBits;
+	numLongsAllocated = numInlineLongs;
+	Clear();
 	FromString(s);
 }
 
 
+/// Allocates a bitstream that is a copy of another bitstream.
+Bitstream::Bitstream(const Bitstream& b2)	///< bitstream to copy
+{
+	numBits = 0;
+	bits = inlineBits;
+	numLongsAllocated = numInlineLongs;
+	*this = b2;
+}
+
+
+/// Takes over the storage of a bitstream that is about to be destroyed.
+Bitstream::Bitstream(Bitstream&& b2)	///< bitstream whose storage is taken
+{
+	numBits = 0;
+	bits = inlineBits;
+	numLongsAllocated = numInlineLongs;
+	*this = std::move(b2);
+}
+
+
 /// Frees the storage used by a bitstream.
 Bitstream::~Bitstream(void)
 {
-    delete [] bits;
+    if (bits != inlineBits)
+    {
+		delete [] bits;
+    }
 	bits = NULL;
 }
 
@@ -80,27 +98,52 @@ unsigned int Bitstream::GetLength(void) const
 }
 
 
-/// Resizes a bitstream while keeping the current bitstream contents.
-///\return true if successful, false if not.
-bool Bitstream::Resize(unsigned int n) ///< new size of bitstream
+/// Makes sure there is storage for at least the given number of words while keeping the current contents.
+/// Any newly-allocated words are cleared.  Storage is never given back, so a bitstream that is reused
+/// for operations of varying size stops allocating once it has grown to the largest size.
+void Bitstream::Reserve(unsigned int numLongs) ///< number of words needed
 {
-    unsigned int numLongs = NUM_OF_LONGS(numBits);
-    unsigned int newnumLongs = NUM_OF_LONGS(n);
     unsigned int i;
     unsigned long *newBits;
 
-    newBits = new unsigned long[newnumLongs];
+    if (numLongs <= numLongsAllocated)
+    {
+		return;
+    }
 
-    for (i = 0; i < MIN(numLongs, newnumLongs); i++)
+    newBits = new unsigned long[numLongs];
+    for (i = 0; i < numLongsAllocated; i++)
     {
 		newBits[i] = bits[i];
     }
-    for( ; i < newnumLongs; i++)
+    for ( ; i < numLongs; i++)
     {
 		newBits[i] = 0;
     }
-    delete [] bits;
+    if (bits != inlineBits)
+    {
+		delete [] bits;
+    }
 	bits = newBits;
+	numLongsAllocated = numLongs;
+}
+
+
+/// Resizes a bitstream while keeping the current bitstream contents.
+///\return true if successful, false if not.
+bool Bitstream::Resize(unsigned int n) ///< new size of bitstream
+{
+    unsigned int numLongs = NUM_OF_LONGS(numBits);
+    unsigned int newnumLongs = NUM_OF_LONGS(n);
+    unsigned int i;
+
+    Reserve(newnumLongs);
+
+    // clear any words that are now part of the bitstream
+    for (i = numLongs; i < newnumLongs; i++)
+    {
+		bits[i] = 0;
+    }
 
 	numBits = n;
 	return true;
@@ -154,20 +197,47 @@ bool Bitstream::Subcompare(unsigned int pos,	///< position in 1st bitstream
 }
 
 
+/// Compares a bitstream against expected bits wherever a mask bit is set.
+/// The bits are compared a word at a time and the compare stops at the first mismatching word.
+///\return true if all the masked bits match, false if not.
+bool Bitstream::MaskedCompare(const Bitstream& expected,	///< bits that should be in this bitstream
+						const Bitstream& mask) const	///< 1 where a bit must match, 0 where it doesn't matter
+{
+    assert(expected.numBits == numBits && mask.numBits == numBits);
+    if (numBits == 0)
+    {
+		return true;
+    }
+
+    unsigned int numLongs = NUM_OF_LONGS(numBits);
+    for (unsigned int i = 0; i < numLongs - 1; i++)
+    {
+        if ((bits[i] ^ expected.bits[i]) & mask.bits[i])
+        {
+			return false;
+        }
+    }
+
+    // ignore the unused bits in the last word
+    unsigned int lastBits = numBits - (numLongs - 1) * bitsPerLong;
+    unsigned long lastMask = lastBits == bitsPerLong ? ~0UL : (1UL << lastBits) - 1;
+    return ((bits[numLongs-1] ^ expected.bits[numLongs-1]) & mask.bits[numLongs-1] & lastMask) == 0;
+}
+
+
 /// Copies contents of one bitstream into another (also adjusts size).
-Bitstream& Bitstream::operator=(Bitstream& b2)
+Bitstream& Bitstream::operator=(const Bitstream& b2)
 {
     unsigned int numLongs2;
     unsigned int i;
 
-    numLongs2 = NUM_OF_LONGS(b2.numBits); // # words in b2
-    if (NUM_OF_LONGS(numBits) != numLongs2)	// compare # words in b1 to b2
+    if (this == &b2)
     {
-        // change size of b1 bitstream to match b2
-        delete [] bits;
-        bits = new unsigned long[numLongs2];
-        assert(bits != NULL);
-	}
+		return *this;
+    }
+
+    numLongs2 = NUM_OF_LONGS(b2.numBits); // # words in b2
+    Reserve(numLongs2);	// only reallocate if b1 isn't already big enough
 	numBits = b2.numBits;
     for(i = 0; i < numLongs2; i++)
     {
@@ -177,6 +247,38 @@ Bitstream& Bitstream::operator=(Bitstream& b2)
 }
 
 
+/// Takes over the storage of a bitstream that is about to be destroyed.
+/// Heap storage is taken over directly; short bitstreams stored in the object are just copied.
+/// The source bitstream is left with zero length.
+Bitstream& Bitstream::operator=(Bitstream&& b2)
+{
+    if (this == &b2)
+    {
+		return *this;
+    }
+
+    if (b2.bits == b2.inlineBits)
+    {
+		*this = (const Bitstream&)b2;
+    }
+    else
+    {
+        if (bits != inlineBits)
+        {
+			delete [] bits;
+        }
+		numBits = b2.numBits;
+		bits = b2.bits;
+		numLongsAllocated = b2.numLongsAllocated;
+		b2.bits = b2.inlineBits;
+		b2.numLongsAllocated = numInlineLongs;
+    }
+	b2.numBits = 0;
+	b2.Clear();
+	return *this;
+}
+
+
 /// Makes a new copy of a bitstream.
 ///\return Pointer to copy of bitstream.
 Bitstream* Bitstream::Copy(void)
@@ -246,47 +348,132 @@ void Bitstream::SetBits( unsigned int bitIndex,	///< position to start changing
 }
 
 
+/// Gives direct access to the storage of a bitstream.
+/// Bit i of the bitstream is bit (i % GetBitsPerWord()) of word (i / GetBitsPerWord()).
+/// Bits in the last word beyond the length of the bitstream are not guaranteed to be zero.
+///\return pointer to the words that hold the bits.
+unsigned long* Bitstream::GetWords(void) const
+{
+	return bits;
+}
+
+
+/// Returns the number of bits stored in each word of a bitstream.
+unsigned int Bitstream::GetBitsPerWord(void)
+{
+	return bitsPerLong;
+}
+
+
 /// XOR two bitstreams.
 ///\return the resulting bitstream.
-Bitstream& Bitstream::operator^(Bitstream& b2) const
+Bitstream Bitstream::operator^(const Bitstream& b2) const
+{
+	Bitstream result(*this);
+	result ^= b2;
+	return result;
+}
+
+
+/// XOR another bitstream into this one.
+///\return this bitstream.
+Bitstream& Bitstream::operator^=(const Bitstream& b2)
 {
     unsigned int numLongs;
     unsigned int i;
 
     assert(numBits == b2.numBits); // operands must have the same size
-	Bitstream& result = *(new Bitstream(numBits));  // result is same size as operands
     numLongs = NUM_OF_LONGS(numBits);
 	
 	// store a 1 in the result anywhere the two bitstreams differ
     for (i = 0; i < numLongs; i++)
     {
-		result.bits[i] = bits[i] ^ b2.bits[i];	// XOR word-by-word
+		bits[i] ^= b2.bits[i];	// XOR word-by-word
     }
-	return result;
+	return *this;
 }
 
 
 /// Concatenate two bitstreams.
 ///\return the concatenated bitstream.
-Bitstream& Bitstream::operator+(Bitstream& b2) const
+Bitstream Bitstream::operator+(const Bitstream& b2) const
 {
-	Bitstream& sum = *(new Bitstream(numBits + b2.numBits));
-    int i;
-    int j;
+	Bitstream sum(0);
+	sum.Concatenate(*this,b2);
+	return sum;
+}
+
+
+/// Store the concatenation of two bitstreams in this bitstream.
+/// The bits of lo occupy the least-significant end of the result (so they are shifted out first).
+/// The storage of this bitstream is reused, so no allocation is done once it is large enough.
+///\return this bitstream.
+Bitstream& Bitstream::Concatenate(const Bitstream& hi,	///< bitstream for the most-significant bits
+								const Bitstream& lo)	///< bitstream for the least-significant bits
+{
+	Bitstream empty(0);
+	return Concatenate(hi,empty,lo);
+}
+
+
+/// Store the concatenation of three bitstreams in this bitstream.
+/// The bits of lo occupy the least-significant end of the result (so they are shifted out first).
+/// The storage of this bitstream is reused, so no allocation is done once it is large enough.
+///\return this bitstream.
+Bitstream& Bitstream::Concatenate(const Bitstream& hi,	///< bitstream for the most-significant bits
+								const Bitstream& mid,	///< bitstream for the middle bits
+								const Bitstream& lo)	///< bitstream for the least-significant bits
+{
+	if (this == &hi || this == &mid || this == &lo)
+	{
+		// build the result separately if this bitstream is also one of the operands
+		Bitstream sum(0);
+		sum.Concatenate(hi,mid,lo);
+		return *this = std::move(sum);
+	}
+
+	Reserve(NUM_OF_LONGS(hi.numBits + mid.numBits + lo.numBits));
+	numBits = hi.numBits + mid.numBits + lo.numBits;
+	Clear();
+	InsertBits(0,lo);
+	InsertBits(lo.numBits,mid);
+	InsertBits(lo.numBits + mid.numBits,hi);
+	return *this;
+}
+
 
-    for (i = sum.numBits - 1, j = numBits - 1; j >= 0; i--, j--)
+/// OR the bits of another bitstream into this one starting at the given position.
+/// The bits of this bitstream in the destination field must already be zero.
+void Bitstream::InsertBits(unsigned int pos,		///< position in this bitstream for bit 0 of src
+						const Bitstream& src)	///< bits to insert
+{
+    unsigned int i;
+
+    assert(pos + src.numBits <= numBits);
+    if (src.numBits == 0)
     {
-        sum.SetBit(i, (*this)[j]);
+		return;
     }
-    assert(j == -1);
 
-    for(j = b2.numBits - 1; j >= 0; i--, j--)
+    unsigned int srcLongs = NUM_OF_LONGS(src.numBits);
+    unsigned int dstLongs = NUM_OF_LONGS(numBits);
+    unsigned int wordIndex = pos / bitsPerLong;
+    unsigned int shift = pos % bitsPerLong;
+    unsigned int lastBits = src.numBits % bitsPerLong;
+
+    for (i = 0; i < srcLongs; i++)
     {
-        sum.SetBit(i, b2[j]);
+        unsigned long b = src.bits[i];
+        if (i == srcLongs - 1 && lastBits != 0)
+        {
+			b &= (1UL << lastBits) - 1;	// don't copy anything past the end of src
+        }
+        bits[wordIndex + i] |= b << shift;
+        if (shift != 0 && wordIndex + i + 1 < dstLongs)
+        {
+			bits[wordIndex + i + 1] |= b >> (bitsPerLong - shift);
+        }
     }
-	assert(i== -1);
-	assert(j== -1);
-	return sum;
 }
 
 
@@ -412,45 +599,72 @@ unsigned char* Bitstream::ToHexString(void) const
 }
 
 
+// Table that translates ASCII characters into hex digit values (0xFF for non-hex characters).
+struct HexDigitTable
+{
+	unsigned char value[256];
+
+	HexDigitTable(void)
+	{
+		memset(value,0xFF,sizeof(value));
+		for(int c = '0'; c <= '9'; c++)
+			value[c] = c - '0';
+		for(int c = 'A'; c <= 'F'; c++)
+			value[c] = value[c - 'A' + 'a'] = c - 'A' + 10;
+	}
+};
+
+
 /// Converts a string of hexadecimal characters into a bitstream.
 ///< convert hex string into a bitstream with this many bits
 ///< string of hex digits to be converted into a bitstream
 ///\return the resulting bitstream
 bool Bitstream::FromHexString(unsigned int nBits, const char *hexString)
 {
+	return FromHexString(nBits, hexString, strlen(hexString));
+}
+
+
+/// Converts a block of hexadecimal characters into a bitstream.
+/// The hex digits are decoded directly into the bitstream words starting
+/// from the least-significant (rightmost) character. Non-hex characters
+/// (such as the parentheses around an SVF TDI field) are skipped.
+///\return true if successful, false if not.
+bool Bitstream::FromHexString(unsigned int nBits,	///< convert hex characters into a bitstream with this many bits
+							  const char *hexString, ///< block of hex digits to be converted into a bitstream
+							  unsigned int nChars)	///< number of characters in the block
+{
+	static const HexDigitTable hexDigit;
+
     Resize(nBits);  // sets numBits == nBits
 
     if (numBits != 0)
     {
-        unsigned int nChars = strlen(hexString);
         unsigned int numLongs = NUM_OF_LONGS(numBits);
-        unsigned int i, j;
-        int k;
+        unsigned int i = 0, j = 0;
+        // This must be a long because its used in a 64 bit shift below
+        unsigned long w = 0;
 
-        for (i = 0, k = nChars - 1; i < numLongs; i++)
+        for (const char *p = hexString + nChars; p > hexString && i < numLongs; )
         {
-            bits[i] = 0;
-            for (j = 0; j < 2 * charsPerLong && k >= 0; k--)
-            {
-                char c;
-
-                c = toupper(hexString[k]);
+            unsigned long b = hexDigit.value[(unsigned char)*--p];
 
-                // skip non-hex characters
-                if (c >= '0' && c <= 'F')
+            // skip non-hex characters
+            if (b != 0xFF)
+            {
+                w |= b << (j * 4);
+                if (++j == nybblesPerLong)
                 {
-                    // This must be a long because its used in a 64 bit shift below
-                    unsigned long b;
-
-                    // ASCII Hex digit to 4 bit value
-                    b = (c >= 'A') ? (c - 'A' + 10) : (c - '0');
-                    bits[i] |= b << (j * 4);
-                    j++;
+                    bits[i++] = w;
+                    w = 0;
+                    j = 0;
                 }
             }
-            assert( (i < numLongs - 1 && j == 2 * charsPerLong) || (i == numLongs - 1 && j > 0) );
-            assert( (i < numLongs - 1 && k >= 0) || (i == numLongs - 1 && k >= -1));
         }
+        if (i < numLongs)
+            bits[i++] = w;
+        for ( ; i < numLongs; i++)
+            bits[i] = 0;	// zero-fill any bits missing from the hex string
     }
 	return true;
 }
@@ -711,9 +925,10 @@ void Bitstream::FromString(const string s)
     unsigned int i, j;
 
 	Resize(s.length());
+	Clear();
 
 	// the last char in the string is the LSB of the bitstream
-    for (i = numBits - 1, j = 0; i >= 0; i--)
+    for (i = s.length(), j = 0; i-- > 0; )
 	{
         // skip whitespace
         if (!isspace(s[i]))
@@ -34,6 +34,11 @@ permits some basic operations on them. It is used primarily for handling
 the strings of instruction and data register bits that go through the 
 JTAG port. 
 
+Bitstreams of up to numInlineLongs words are stored inside the object 
+itself, so the short instruction and data registers used for most JTAG 
+operations don't touch the heap. Storage is only allocated for larger 
+bitstreams. 
+
 */
 class Bitstream
 {
@@ -43,6 +48,10 @@ class Bitstream
 
 	Bitstream(const string s);
 
+	Bitstream(const Bitstream& b2);
+
+	Bitstream(Bitstream&& b2);
+
 	~Bitstream(void);
 
 	unsigned int GetLength(void) const;
@@ -53,7 +62,11 @@ class Bitstream
 
 	bool Subcompare(unsigned int pos, Bitstream& b2, unsigned int b2Pos) const;
 
-	Bitstream& operator=(Bitstream& b2);
+	bool MaskedCompare(const Bitstream& expected, const Bitstream& mask) const;
+
+	Bitstream& operator=(const Bitstream& b2);
+
+	Bitstream& operator=(Bitstream&& b2);
 
 	Bitstream* Copy(void);
 
@@ -65,9 +78,19 @@ class Bitstream
 
 	void SetBits(unsigned int bitIndex,	int firstBit, ... );
 
-	Bitstream& operator^(Bitstream& b2) const;
+	unsigned long* GetWords(void) const;
+
+	static unsigned int GetBitsPerWord(void);
+
+	Bitstream operator^(const Bitstream& b2) const;
 
-	Bitstream& operator+(Bitstream& b2) const;
+	Bitstream& operator^=(const Bitstream& b2);
+
+	Bitstream operator+(const Bitstream& b2) const;
+
+	Bitstream& Concatenate(const Bitstream& hi, const Bitstream& lo);
+
+	Bitstream& Concatenate(const Bitstream& hi, const Bitstream& mid, const Bitstream& lo);
 
 	void ShiftRight(unsigned int rightShift);
 
@@ -79,6 +102,8 @@ class Bitstream
 
 	bool FromHexString(unsigned int nBits, const char *hexString);
 
+	bool FromHexString(unsigned int nBits, const char *hexString, unsigned int nChars);
+
 	bool FromHexStream(unsigned int nBits, istream& is, bool reverseBits);
 
     unsigned char* ToCharString() const;
@@ -97,8 +122,16 @@ class Bitstream
 
 	private:
 
+	void Reserve(unsigned int numLongs);
+
+	void InsertBits(unsigned int pos, const Bitstream& src);
+
+	static const unsigned int numInlineLongs = 4;	///< number of words stored in the object before using the heap
+
 	unsigned int numBits;	///< number of bits in bitstream
-	unsigned long* bits;	///< storage for bitstream
+	unsigned long* bits;	///< storage for bitstream (points to inlineBits for short bitstreams)
+	unsigned int numLongsAllocated;	///< number of words of storage (may be more than numBits needs)
+	unsigned long inlineBits[numInlineLongs];	///< storage for short bitstreams
 };
 
 ostream& operator<<(ostream& os, Bitstream& b);
@@ -78,7 +78,7 @@ class CnfgPort : public PPort
 	unsigned int GetDONE(void);
 
 	
-	private:
+	protected:
 
 	unsigned int posCCLK;	///< position of configuration clock pin
 	unsigned int posPROG;	///< position of configuration initiation pin 
@@ -0,0 +1,143 @@
+/*----------------------------------------------------------------------------------
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+	02111-1307, USA.
+
+	1997-2010 - X Engineering Software Systems Corp.
+----------------------------------------------------------------------------------*/
+
+
+
+#include <ctime>
+#include <cerrno>
+#include <sstream>
+#include <iomanip>
+#include <time.h>
+using namespace std;
+
+#include "utils.h"
+#include "delaytmr.h"
+
+
+// Delays shorter than this are done entirely by spinning on the clock.
+static const unsigned long long spinThreshold = 100000ULL;	// ns
+
+// Sleeping delays wake up this long before the deadline and spin the rest of the way
+// to cover the scheduler's wakeup latency and timer slack.
+static const unsigned long long spinMargin = 80000ULL;		// ns
+
+static const unsigned long long nsPerSec = 1000000000ULL;
+
+unsigned long DelayTimer::requestedHist[DelayTimer::numBins];
+unsigned long DelayTimer::actualHist[DelayTimer::numBins];
+unsigned long long DelayTimer::totalRequested = 0;
+unsigned long long DelayTimer::totalActual = 0;
+unsigned long long DelayTimer::maxOvershoot = 0;
+
+
+/// Get the current time from the monotonic clock.
+///\return the current time in nanoseconds.
+unsigned long long DelayTimer::Now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (unsigned long long)t.tv_sec * nsPerSec + t.tv_nsec;
+}
+
+
+/// Delay for a given number of nanoseconds, microseconds or milliseconds.
+void DelayTimer::Delay(unsigned long d,			///< number of time units to delay
+					unsigned int time_units)	///< time units, either NANOSECONDS, MICROSECONDS or MILLISECONDS
+{
+	if(time_units == MILLISECONDS)
+		DelayNs((unsigned long long)d * 1000000ULL);
+	else if(time_units == MICROSECONDS)
+		DelayNs((unsigned long long)d * 1000ULL);
+	else
+		DelayNs(d);
+}
+
+
+/// Delay for a given number of nanoseconds.
+void DelayTimer::DelayNs(unsigned long long ns)	///< number of nanoseconds to delay
+{
+	unsigned long long start = Now();
+	unsigned long long deadline = start + ns;
+
+	if(ns >= spinThreshold)
+	{
+		// sleep until just before the deadline
+		unsigned long long wake = deadline - spinMargin;
+		struct timespec t;
+		t.tv_sec = wake / nsPerSec;
+		t.tv_nsec = wake % nsPerSec;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR)
+			;	// restart the sleep if a signal interrupted it
+	}
+
+	// spin for the rest of the delay
+	unsigned long long now;
+	while((now = Now()) < deadline)
+		;
+
+	// record the delay
+	unsigned long long actual = now - start;
+	requestedHist[Bin(ns)]++;
+	actualHist[Bin(actual)]++;
+	totalRequested += ns;
+	totalActual += actual;
+	if(actual - ns > maxOvershoot)
+		maxOvershoot = actual - ns;
+}
+
+
+/// Get the histogram bin for a delay.
+///\return index of the bin.
+unsigned int DelayTimer::Bin(unsigned long long ns)	///< delay in nanoseconds
+{
+	unsigned int bin = 0;
+	while(ns > 1 && bin < numBins-1)
+	{
+		ns >>= 1;
+		bin++;
+	}
+	return bin;
+}
+
+
+/// Clear the delay histograms.
+void DelayTimer::ResetStats(void)
+{
+	for(unsigned int i=0; i<numBins; i++)
+		requestedHist[i] = actualHist[i] = 0;
+	totalRequested = totalActual = maxOvershoot = 0;
+}
+
+
+/// Format the delay histograms as a table.
+///\return a string with one line for each non-empty bin plus a summary line.
+string DelayTimer::GetStats(void)
+{
+	ostringstream os;
+
+	os << setw(14) << ">= ns" << setw(12) << "requested" << setw(12) << "actual" << "\n";
+	for(unsigned int i=0; i<numBins; i++)
+	{
+		if(requestedHist[i]!=0 || actualHist[i]!=0)
+			os << setw(14) << (1ULL<<i) << setw(12) << requestedHist[i] << setw(12) << actualHist[i] << "\n";
+	}
+	os << "total requested = " << totalRequested << " ns, total actual = " << totalActual
+	   << " ns, max overshoot = " << maxOvershoot << " ns\n";
+	return os.str();
+}
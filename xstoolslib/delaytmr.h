@@ -0,0 +1,70 @@
+/*----------------------------------------------------------------------------------
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+	02111-1307, USA.
+
+	1997-2010 - X Engineering Software Systems Corp.
+----------------------------------------------------------------------------------*/
+
+
+
+#ifndef DELAYTMR_H
+#define DELAYTMR_H
+
+#include <string>
+using namespace std;
+
+
+/**
+Generates time delays using the monotonic system clock.
+
+This object replaces the old calibrated busy-wait loops with delays that 
+are measured against CLOCK_MONOTONIC. Long delays sleep with 
+clock_nanosleep() until shortly before the deadline and then spin for the 
+remainder, while delays shorter than the spin threshold just spin on the 
+clock. This keeps delays accurate without tying up the CPU during the 
+long waits used for things like the SVF RUNTEST command or Flash erasure. 
+
+The requested and actual durations of every delay are accumulated in 
+histograms with power-of-two bins so the accuracy of the delays can be 
+examined after an operation. 
+*/
+class DelayTimer
+{
+	public:
+
+	static void Delay(unsigned long d, unsigned int time_units);
+
+	static void DelayNs(unsigned long long ns);
+
+	static unsigned long long Now(void);
+
+	static void ResetStats(void);
+
+	static string GetStats(void);
+
+
+	private:
+
+	static unsigned int Bin(unsigned long long ns);
+
+	static const unsigned int numBins = 32;			///< number of histogram bins (bin i holds delays in [2^i, 2^(i+1)) ns)
+	static unsigned long requestedHist[numBins];	///< histogram of requested delays
+	static unsigned long actualHist[numBins];		///< histogram of actual delays
+	static unsigned long long totalRequested;		///< sum of all requested delays (ns)
+	static unsigned long long totalActual;			///< sum of all actual delays (ns)
+	static unsigned long long maxOvershoot;			///< largest amount by which a delay exceeded its request (ns)
+};
+
+#endif
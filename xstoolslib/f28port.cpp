@@ -198,6 +198,28 @@ bool F28Port::EraseFlashBlock(unsigned int blockIndex) ///< index of Flash block
 }
 
 
+/// Get the number of erasable blocks in the Flash.
+///\return the number of blocks.
+unsigned int F28Port::GetNumFlashBlocks(void)
+{
+	return sizeof(flashBlocks)/sizeof(struct flashBlock);
+}
+
+
+/// Get the location of an erasable block in the Flash.
+///\return true if the block exists, false if not.
+bool F28Port::GetFlashBlock(unsigned int blockIndex,	///< index of Flash block
+					unsigned int* address,	///< returns the address of the first byte in the block
+					unsigned int* length)	///< returns the number of bytes in the block
+{
+	if(blockIndex >= GetNumFlashBlocks())
+		return false;
+	*address = flashBlocks[blockIndex].address;
+	*length = flashBlocks[blockIndex].length;
+	return true;
+}
+
+
 /// Reset the Flash so data can be read from it.
 ///\return true if successful, false if not.
 bool F28Port::ResetFlash(void)
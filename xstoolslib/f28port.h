@@ -59,6 +59,10 @@ class F28Port : public FlashPort
 
 	bool EraseFlashBlock(unsigned int blockIndex);
 
+	unsigned int GetNumFlashBlocks(void);
+
+	bool GetFlashBlock(unsigned int blockIndex, unsigned int* address, unsigned int* length);
+
 	bool ResetFlash(void);
 
 	bool ReadFlashID(unsigned int* id);
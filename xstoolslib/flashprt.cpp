@@ -20,18 +20,57 @@
 
 #include <fstream>
 #include <cassert>
+#include <chrono>
+#include <map>
+#include <vector>
 
 #include <string.h>
 
 #include "utils.h"
 #include "hexrecrd.h"
+#include "heximage.h"
+#include "uploadpipe.h"
+#include "parameters.h"
 #include "flashprt.h"
 
 
+static const unsigned int erasedFlashByte = 0xFF;	// value of every byte in an erased Flash block
+static const unsigned int maxProgramRun = 0x100;	// most bytes programmed between progress reports
+
+
+/// Sector layouts of the Flash chips found on XS Boards.
+static const FlashSectorRun lv160TopSectors[]    = {{31,0x10000}, {1,0x8000}, {2,0x2000}, {1,0x4000}, {0,0}};
+static const FlashSectorRun lv160BottomSectors[] = {{1,0x4000}, {2,0x2000}, {1,0x8000}, {31,0x10000}, {0,0}};
+static const FlashSectorRun lv320TopSectors[]    = {{63,0x10000}, {8,0x2000}, {0,0}};
+static const FlashSectorRun lv320BottomSectors[] = {{8,0x2000}, {63,0x10000}, {0,0}};
+
+
+/// Programming features of the Flash chips found on XS Boards.
+/// The S29GL family shares one device code across several sizes, so its layout isn't known.
+static const FlashType flashTypes[] =
+{
+	// manufacturer, device, name, unlock bypass, write buffer bytes, sectors
+	{0x01, 0xC4, "Am29LV160D/S29AL016D (top boot)",		true,	0,	lv160TopSectors},
+	{0x01, 0x49, "Am29LV160D/S29AL016D (bottom boot)",	true,	0,	lv160BottomSectors},
+	{0x01, 0xF6, "Am29LV320D/S29AL032D (top boot)",		true,	0,	lv320TopSectors},
+	{0x01, 0xF9, "Am29LV320D/S29AL032D (bottom boot)",	true,	0,	lv320BottomSectors},
+	{0x01, 0x7E, "S29GL-N/S29GL-P",						true,	32,	NULL},
+	{0x1F, 0x07, "AT49F002",							false,	0,	NULL},
+	{0x1F, 0x08, "AT49F002T",							false,	0,	NULL},
+};
+
+
 /// Create a Flash upload/download port.
 FlashPort::FlashPort(void)
 {
 	progressGauge = NULL;
+	bytesProgrammed = 0;
+	bytesSkipped = 0;
+	downloadRate = 0;
+	flashType = NULL;
+	flashTypeRead = false;
+	fastProgram = false;
+	uploadRate = 0;
 }
 
 
@@ -49,6 +88,13 @@ FlashPort::FlashPort(XSError* e,	///< pointer to error reporting object
 				   unsigned int pos_stmsb)	///< bit position in parallel port of MSB of Flash status pin
 {
 	progressGauge = NULL;
+	bytesProgrammed = 0;
+	bytesSkipped = 0;
+	downloadRate = 0;
+	flashType = NULL;
+	flashTypeRead = false;
+	fastProgram = false;
+	uploadRate = 0;
 	Setup(e,portNum,invMask,pos_reset,pos_clk,
 		pos_dolsb,pos_domsb,
 		pos_dilsb,pos_dimsb,
@@ -95,6 +141,25 @@ bool FlashPort::DownloadFlash(const char *hexfileName,	///< name of file contain
     if(strlen(hexfileName)==0)
 		return false;  // stop if no hex file was given
 	
+	string desc("Flash Download"), subdesc("Downloading "+StripPrefix(hexfileName));
+
+	if(HexImage::CanLoad(hexfileName))
+	{ // load the whole hex or binary file at once and program it a block at a time
+		HexImage image;
+		if(!image.Load(hexfileName,err))
+			return false;
+		status = false;
+		progressGauge = new Progress(NULL, &err);
+		if (NULL != progressGauge)
+		{
+			progressGauge->Setup(desc,subdesc,0,image.GetNumBytes());
+			status = DownloadFlash(image,bigEndianBytes,bigEndianBits,doErase);
+			delete progressGauge;
+			progressGauge = NULL;
+		}
+		return status;
+	}
+
     ifstream is(hexfileName, ios::binary);  // otherwise open hex file
 	if(!is || is.fail() || is.eof()!=0)
 	{ // error - couldn't open hex file
@@ -109,7 +174,6 @@ bool FlashPort::DownloadFlash(const char *hexfileName,	///< name of file contain
 	streampos streamEndPos = is.tellg();	// pointer position = position of end of file
 	is.seekg(0,ios::beg);	// return pointer to beginning of file
 
-	string desc("Flash Download"), subdesc("Downloading "+StripPrefix(hexfileName));
     progressGauge = new Progress(NULL, &err);
     progressGauge->Setup(desc,subdesc,0,streamEndPos);
     if (NULL != progressGauge)
@@ -133,43 +197,93 @@ bool FlashPort::DownloadFlash( istream& is,	///< stream through which hex data i
 {
 	XSError& err = GetErr();
 
-	if(doErase)
-		EraseFlash();	// erase the entire Flash
+	// collect the hex records into an image so they are programmed just like a hex file
+	HexImage image;
+	if(!image.Read(is,err))
+		return false;
+	is.clear();	// the stream position is only wanted for the progress gauge
+	long streamEndPos = is.tellg();
+	return DownloadImage(image,streamEndPos>0 ? streamEndPos : 1,bigEndianBytes,bigEndianBits,doErase);
+}
 
-	assert(progressGauge != NULL);	//	make sure progress indicator is initialized
-	progressGauge->Report(0);	// start progress indicator at zero
 
-	// read hex records from file and place data in the Flash of the board
-	HexRecord hx;
-	while(is.eof()==0)
+/// Download the XS Board Flash with the contents of a hex image.
+///\return true if the operation was successful, false otherwise
+bool FlashPort::DownloadFlash(const HexImage& image,	///< data to be programmed into the Flash
+					bool bigEndianBytes,	///< if true, data is stored in Flash with most-significant byte at lower address
+					bool bigEndianBits,		///< if true, data is stored in Flash with most-significant bit in position 0
+					bool doErase)			///< if true, then erase Flash before downloading data
+{
+	return DownloadImage(image,image.GetNumBytes(),bigEndianBytes,bigEndianBits,doErase);
+}
+
+
+/// Program a hex image into the Flash and measure the download rate.
+///\return true if the operation was successful, false otherwise
+bool FlashPort::DownloadImage(const HexImage& image,	///< data to be programmed into the Flash
+					unsigned long gaugeEnd,	///< value of the progress gauge when the download is done
+					bool bigEndianBytes,	///< if true, data is stored in Flash with most-significant byte at lower address
+					bool bigEndianBits,		///< if true, data is stored in Flash with most-significant bit in position 0
+					bool doErase)			///< if true, then erase Flash before downloading data
+{
+	XSError& err = GetErr();
+
+	bytesProgrammed = 0;
+	bytesSkipped = 0;
+	flashTypeRead = false;	// the board may have been changed since the last download
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	bool status = true;
+	if(IsIncremental(doErase))
+	{ // only change the blocks that need it if the layout of the Flash is known
+		status = UpdateFlash(image,gaugeEnd,bigEndianBytes,bigEndianBits);
+	}
+	else
 	{
-		is >> hx;
-		if(is.eof()!=0)
-			break; // terminate loading loop when stream goes dry
-		if(is.fail() || err.IsError())
+		if(doErase && EraseFlash() == false)	// erase the entire Flash
 		{
 			err.SetSeverity(XSErrorMajor);
-			err << "error reading stream\n";
-			err.EndMsg();
-			break;
-		}
-		if(hx.IsError())
-		{ // some error in the hex record itself
-			err.SetSeverity(XSErrorMajor);
-			err << "hex record: " << hx.GetErrMsg() << "\n";
+			err << "Failure erasing the Flash\n";
 			err.EndMsg();
-			break;
+			return false;
 		}
-		else
-		{ // send out an indication for each hex record that's loaded
-			progressGauge->Report(is.tellg());
-			if(DownloadHexRecordToFlash(hx,bigEndianBytes,bigEndianBits) == false)
-				return false;
+
+		assert(progressGauge != NULL);	//	make sure progress indicator is initialized
+		progressGauge->Report(0);	// start progress indicator at zero
+
+		// program each extent of the image a run at a time so progress can be shown
+		status = StartProgramming();
+		unsigned long numBytes = max(image.GetNumBytes(),1UL);
+		unsigned long bytesDone = 0;
+		for(unsigned int e=0; status && e<image.GetNumExtents(); e++)
+		{
+			const HexExtent& extent = image.GetExtent(e);
+			for(unsigned long i=0; status && i<extent.data.size(); i+=maxProgramRun)
+			{
+				unsigned int n = min((unsigned long)maxProgramRun, (unsigned long)extent.data.size()-i);
+				status = ProgramFlashBytes(extent.address+i,&extent.data[i],n,doErase,bigEndianBytes,bigEndianBits);
+				bytesDone += n;
+				progressGauge->Report((float)gaugeEnd * bytesDone / numBytes);
+			}
 		}
+		if(status)
+			progressGauge->Report(gaugeEnd);	// should set gauge to 100%
+		status = EndProgramming() && status && !err.IsError();
 	}
-	progressGauge->Report(is.tellg());	// should set gauge to 100%
-	
-	return err.IsError() ? false:true;
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	downloadRate = (seconds > 0) ? (bytesProgrammed + bytesSkipped) / seconds : 0;
+	DEBUG_STMT("Flash download programmed " << bytesProgrammed << " bytes, skipped " << bytesSkipped << " bytes, " << (long)downloadRate << " bytes/s")
+
+	return status;
+}
+
+
+/// Check if a download should only change the Flash blocks that differ from the data.
+///\return true if the Flash is to be erased and the layout of its blocks is known
+bool FlashPort::IsIncremental(bool doErase)	///< true if the Flash would be erased before the download
+{
+	return doErase && GetNumFlashBlocks()>0 && Parameters::GetXSTOOLSParameter("FLASHINCREMENTAL")!="NO";
 }
 
 
@@ -180,9 +294,8 @@ bool FlashPort::DownloadHexRecordToFlash(
 					bool bigEndianBytes,	///< if true, data is stored in Flash with most-significant byte at lower address
 					bool bigEndianBits)		///< if true, data is stored in Flash with most-significant bit in position 0
 {
-	if(hx.IsData()) // don't download unless this is Flash data
+	if(hx.IsData() && hx.GetLength()>0) // don't download unless this is Flash data
 	{
-		unsigned int i;
 		unsigned int address = hx.GetAddress();	// get starting address for hex record
 //		for(int j=sizeof(flashBlocks)/sizeof(struct flashBlock)-1; j>=0; j--)
 //		{
@@ -194,27 +307,381 @@ bool FlashPort::DownloadHexRecordToFlash(
 //					EraseFlashBlock(j);
 //			}
 //		}
-		for(i=0; i<hx.GetLength(); i++)
+		return ProgramFlashBytes(address,&hx[0],hx.GetLength(),false,bigEndianBytes,bigEndianBits);
+	}
+	return true;
+}
+
+
+/// Program consecutive bytes into the Flash and report the address if it fails.
+/// If the Flash is known to be erased, bytes with the erased value are not programmed
+/// since that wouldn't change them. The other bytes go through the write buffer of the
+/// chip if it has one.
+///\return true if the operation was successful, false otherwise
+bool FlashPort::ProgramFlashBytes(unsigned int address,	///< address at which to store the first byte
+					const unsigned char* data,	///< data bytes to be stored
+					unsigned int length,	///< number of data bytes
+					bool erased,			///< true if the bytes were erased since they were last programmed
+					bool bigEndianBytes,	///< if true, data is stored in Flash with most-significant byte at lower address
+					bool bigEndianBits)		///< if true, data is stored in Flash with most-significant bit in position 0
+{
+	unsigned int bufferSize = 1;
+	if(IsFastProgram() && flashType->writeBufferSize>1)
+		bufferSize = flashType->writeBufferSize;
+
+	unsigned int i = 0;
+	while(i < length)
+	{
+		if(erased && data[i]==erasedFlashByte)
+		{ // programming can only clear bits, so this would leave the byte as it is
+			bytesSkipped++;
+			i++;
+			continue;
+		}
+
+		// collect the bytes that can go into the write buffer together
+		unsigned int n = 1;
+		while(i+n<length && !(erased && data[i+n]==erasedFlashByte) && (address+i+n)%bufferSize!=0)
+			n++;
+
+		bool programmed;
+		if(n == 1)
+			programmed = ProgramFlash(address+i,data[i],bigEndianBytes,bigEndianBits);
+		else
+			programmed = ProgramFlashBuffer(address+i,data+i,n,bigEndianBytes,bigEndianBits);
+		if(programmed == false)
+		{
+			int testStatus = 0;
+			int j;
+			for(j=0; j<100; j++)
+				testStatus += Test();
+			XSError& err = GetErr();
+			err.SetSeverity(XSErrorMajor);
+			err << "Failure in DownloadHexRecordToFlash at address " << (long int)(address+i) << "\n";
+			err << "Parallel port response factor = " << (float)testStatus/j << "\n";
+			err.EndMsg();
+			return false;
+		}
+		bytesProgrammed += n;
+		i += n;
+	}
+	return true;
+}
+
+
+/// Data from a hex file that falls in one block of the Flash.
+struct FlashBlockImage
+{
+	vector<unsigned char> data;	///< bytes to store in the block (erased value where the hex file gives none)
+	vector<bool> used;			///< true for each byte that is given in the hex file
+};
+
+
+/// Update the Flash with the contents of a hex image, erasing and programming only the blocks that change.
+/// Each block the image touches ends up holding the image data and the erased value everywhere
+/// else, just as if the whole Flash had been erased. The blocks the image doesn't touch are left alone.
+///\return true if the operation was successful, false otherwise
+bool FlashPort::UpdateFlash(const HexImage& hexImage,	///< data to be programmed into the Flash
+					unsigned long gaugeEnd,	///< value of the progress gauge when the update is done
+					bool bigEndianBytes,	///< if true, data is stored in Flash with most-significant byte at lower address
+					bool bigEndianBits)		///< if true, data is stored in Flash with most-significant bit in position 0
+{
+	XSError& err = GetErr();
+
+	assert(progressGauge != NULL);	//	make sure progress indicator is initialized
+	progressGauge->Report(0);	// start progress indicator at zero
+
+	// sort the data in the hex image into the Flash blocks it falls into
+	map<unsigned int,FlashBlockImage> image;	// images of the blocks touched by the hex image, by block index
+	unsigned int blkIndex = 0, blkAddr = 0, blkLen = 0;
+	for(unsigned int e=0; e<hexImage.GetNumExtents(); e++)
+	{
+		const HexExtent& extent = hexImage.GetExtent(e);
+		for(unsigned long i=0; i<extent.data.size(); i++)
+		{
+			unsigned int address = extent.address + i;
+			if(address < blkAddr || address-blkAddr >= blkLen)
+			{ // find the block that holds this address
+				for(blkIndex=0; GetFlashBlock(blkIndex,&blkAddr,&blkLen); blkIndex++)
+				{
+					if(address >= blkAddr && address-blkAddr < blkLen)
+						break;
+				}
+				if(blkIndex == GetNumFlashBlocks())
+				{
+					blkLen = 0;
+					err.SetSeverity(XSErrorMajor);
+					err << "address " << (long)address << " is outside the Flash\n";
+					err.EndMsg();
+					return false;
+				}
+			}
+			FlashBlockImage& blk = image[blkIndex];
+			if(blk.data.empty())
+			{
+				blk.data.resize(blkLen,erasedFlashByte);
+				blk.used.resize(blkLen,false);
+			}
+			blk.data[address-blkAddr] = extent.data[i];
+			blk.used[address-blkAddr] = true;
+		}
+	}
+	unsigned long numBytes = hexImage.GetNumBytes();	// number of data bytes in the hex image
+	if(numBytes == 0)
+		numBytes = 1;
+
+	// compare each touched block with the Flash and rewrite the blocks that differ
+	unsigned long bytesDone = 0;
+	unsigned int numChanged = 0;
+	for(map<unsigned int,FlashBlockImage>::iterator b=image.begin(); b!=image.end(); b++)
+	{
+		if(progressGauge->UserHasCancelled())
+			return false;
+
+		GetFlashBlock(b->first,&blkAddr,&blkLen);
+		FlashBlockImage& blk = b->second;
+		unsigned long blkBytes = 0;
+
+		// read back the block and see how it has to change (including the bytes the hex file doesn't set)
+		vector<unsigned char> current(blkLen,erasedFlashByte);
+		bool changed = false;
+		bool needsErase = false;	// true if some bit has to go from 0 to 1
+		ResetFlash();
+		for(unsigned int i=0; i<blkLen; i++)
 		{
-			if(ProgramFlash(address+i,hx[i],bigEndianBytes,bigEndianBits) == false)
+			unsigned int d;
+			if(ReadFlashByte(blkAddr+i,&d,bigEndianBytes,bigEndianBits) == false)
 			{
-				int testStatus = 0;
-				int j;
-				for(j=0; j<100; j++)
-					testStatus += Test();
-				XSError& err = GetErr();
 				err.SetSeverity(XSErrorMajor);
-				err << "Failure in DownloadHexRecordToFlash at address " << (long int)(address+i) << "\n";
-				err << "Parallel port response factor = " << (float)testStatus/j << "\n";
+				err << "Failure reading the Flash at address " << (long)(blkAddr+i) << "\n";
 				err.EndMsg();
 				return false;
 			}
+			current[i] = d;
+			changed = changed || (d != blk.data[i]);
+			needsErase = needsErase || ((d & blk.data[i]) != blk.data[i]);
+		}
+
+		if(changed)
+		{
+			numChanged++;
+			if(needsErase)
+			{
+				if(EraseFlashBlock(b->first) == false)
+				{
+					err.SetSeverity(XSErrorMajor);
+					err << "Failure erasing the Flash block at address " << (long)blkAddr << "\n";
+					err.EndMsg();
+					return false;
+				}
+				current.assign(blkLen,erasedFlashByte);
+			}
+			if(StartProgramming() == false)
+				return false;
+		}
+		unsigned int i = 0;
+		while(i < blkLen)
+		{
+			if(current[i]==blk.data[i])
+			{
+				if(blk.used[i])
+				{
+					bytesSkipped++;	// already holds the right value
+					blkBytes++;
+				}
+				i++;
+				continue;
+			}
+
+			// program the run of bytes that have to change
+			// (the bytes the hex file doesn't set are left erased, so they never need programming)
+			unsigned int n = 1;
+			while(i+n<blkLen && n<maxProgramRun && current[i+n]!=blk.data[i+n])
+				n++;
+			if(ProgramFlashBytes(blkAddr+i,&blk.data[i],n,needsErase,bigEndianBytes,bigEndianBits) == false)
+			{
+				EndProgramming();
+				return false;
+			}
+			i += n;
+			blkBytes += n;
+			progressGauge->Report((float)gaugeEnd * (bytesDone+blkBytes) / numBytes);
+		}
+		if(changed && EndProgramming()==false)
+			return false;
+		bytesDone += blkBytes;
+		progressGauge->Report((float)gaugeEnd * bytesDone / numBytes);
+	}
+	DEBUG_STMT("Flash update changed " << numChanged << " of " << image.size() << " blocks")
+
+	progressGauge->Report(gaugeEnd);	// should set gauge to 100%
+	return err.IsError() ? false:true;
+}
+
+
+/// Get the number of bytes the last download wrote to the Flash.
+///\return the number of bytes programmed.
+unsigned long FlashPort::GetBytesProgrammed(void) const
+{
+	return bytesProgrammed;
+}
+
+
+/// Get the number of bytes the last download didn't have to write because the Flash already held them.
+///\return the number of bytes skipped.
+unsigned long FlashPort::GetBytesSkipped(void) const
+{
+	return bytesSkipped;
+}
+
+
+/// Get the effective transfer rate of the last download.
+///\return the number of bytes of hex data loaded per second, whether they were programmed or skipped.
+double FlashPort::GetDownloadRate(void) const
+{
+	return downloadRate;
+}
+
+
+/// Identify the Flash chip and look up its programming features and sector layout.
+/// The chip is identified once per download.
+///\return the type of the Flash chip, or NULL if it isn't known.
+const FlashType* FlashPort::GetFlashType(void)
+{
+	if(!flashTypeRead)
+	{
+		flashTypeRead = true;
+		flashType = NULL;
+		fastProgram = false;
+		unsigned int manufacturerId, deviceId;
+		if(ReadFlashId(&manufacturerId,&deviceId))
+		{
+			flashType = FindFlashType(manufacturerId,deviceId);
+			fastProgram = flashType!=NULL && Parameters::GetXSTOOLSParameter("FLASHFASTPROGRAM")!="NO";
+			DEBUG_STMT("Flash ID " << manufacturerId << ":" << deviceId << " is " << (flashType!=NULL ? flashType->name : "unknown"))
 		}
 	}
+	return flashType;
+}
+
+
+/// Check if the unlock bypass and write buffer features of the Flash chip can be used.
+/// They aren't used if the XSTOOLS parameter FLASHFASTPROGRAM is NO, so only the basic commands are used.
+///\return true if the chip is known and fast programming is allowed.
+bool FlashPort::IsFastProgram(void)
+{
+	GetFlashType();
+	return fastProgram;
+}
+
+
+/// Find the programming features of a Flash chip from its autoselect codes.
+///\return the type of the Flash chip, or NULL if it isn't in the table.
+const FlashType* FlashPort::FindFlashType(unsigned int manufacturerId,	///< manufacturer code of the chip
+					unsigned int deviceId)	///< device code of the chip
+{
+	for(unsigned int i=0; i<sizeof(flashTypes)/sizeof(flashTypes[0]); i++)
+	{
+		if(flashTypes[i].manufacturerId==manufacturerId && flashTypes[i].deviceId==deviceId)
+			return &flashTypes[i];
+	}
+	return NULL;
+}
+
+
+/// Read the manufacturer and device codes of the Flash chip.
+/// Devices that can't be identified return false, so they are programmed with the basic commands.
+///\return true if the codes were read, false if not.
+bool FlashPort::ReadFlashId(unsigned int* manufacturerId,	///< returns the manufacturer code
+					unsigned int* deviceId)	///< returns the device code
+{
+	return false;
+}
+
+
+/// Get the Flash ready for a series of ProgramFlash() and ProgramFlashBuffer() calls.
+/// The Flash must not be erased until EndProgramming() is called.
+///\return true if successful, false if not.
+bool FlashPort::StartProgramming(void)
+{
+	return true;
+}
+
+
+/// Return the Flash to its normal command mode after programming.
+///\return true if successful, false if not.
+bool FlashPort::EndProgramming(void)
+{
+	return true;
+}
+
+
+/// Program consecutive bytes that lie in a single page of the write buffer.
+/// Devices without a write buffer program the bytes one at a time.
+///\return true if successful, false if not.
+bool FlashPort::ProgramFlashBuffer(unsigned int address,	///< address at which to store the first byte
+					const unsigned char* data,	///< data bytes to be stored
+					unsigned int length,	///< number of data bytes
+					bool bigEndianBytes,	///< if true, data is stored in Flash with most-significant byte at lower address
+					bool bigEndianBits)		///< if true, data is stored in Flash with most-significant bit in position 0
+{
+	for(unsigned int i=0; i<length; i++)
+	{
+		if(ProgramFlash(address+i,data[i],bigEndianBytes,bigEndianBits) == false)
+			return false;
+	}
 	return true;
 }
 
 
+/// Get the transfer rate of the last upload.
+///\return the number of bytes uploaded per second.
+double FlashPort::GetUploadRate(void) const
+{
+	return uploadRate;
+}
+
+
+/// Get the number of erasable blocks in the Flash from the sector layout of the detected chip.
+/// Chips with an unknown layout return zero, so they are always erased as a whole.
+///\return the number of blocks.
+unsigned int FlashPort::GetNumFlashBlocks(void)
+{
+	const FlashType* type = GetFlashType();
+	if(type==NULL || type->sectors==NULL)
+		return 0;
+	unsigned int numBlocks = 0;
+	for(const FlashSectorRun* run=type->sectors; run->count>0; run++)
+		numBlocks += run->count;
+	return numBlocks;
+}
+
+
+/// Get the location of an erasable block in the Flash from the sector layout of the detected chip.
+///\return true if the block exists, false if not.
+bool FlashPort::GetFlashBlock(unsigned int blockIndex,	///< index of Flash block
+					unsigned int* address,	///< returns the address of the first byte in the block
+					unsigned int* length)	///< returns the number of bytes in the block
+{
+	const FlashType* type = GetFlashType();
+	if(type==NULL || type->sectors==NULL)
+		return false;
+	unsigned int runAddress = 0;
+	for(const FlashSectorRun* run=type->sectors; run->count>0; run++)
+	{
+		if(blockIndex < run->count)
+		{
+			*address = runAddress + blockIndex*run->length;
+			*length = run->length;
+			return true;
+		}
+		blockIndex -= run->count;
+		runAddress += run->count*run->length;
+	}
+	return false;
+}
+
+
 /// Write a byte to the Flash through the parallel port.
 ///\return true if the operation was successful, false otherwise
 bool FlashPort::WriteFlashByte(unsigned int address,	///< address at which to store data
@@ -311,8 +778,11 @@ bool FlashPort::UploadFlash(const char *hexfileName,	///< dump uploaded data to
     // stop if no hex file was given
     if (0 != strlen(hexfileName))
     {
-        // otherwise open hex file
-        ofstream os(hexfileName);
+        // otherwise open hex file with a big buffer so the records go to disk in large writes
+        vector<char> fileBuf(HEX_FILE_BUFFER_SIZE);
+        ofstream os;
+        os.rdbuf()->pubsetbuf(&fileBuf[0],fileBuf.size());
+        os.open(hexfileName, IsBinaryFormat(format) ? ios::out|ios::binary : ios::out);
         if (os.fail() || os.eof() != 0)
         {
             // error - couldn't open hex file
@@ -329,6 +799,11 @@ bool FlashPort::UploadFlash(const char *hexfileName,	///< dump uploaded data to
                 progressGauge->Setup(desc, subdesc.append(hexfileName), loAddr, hiAddr);
 
                 status = UploadFlash(os, format, loAddr, hiAddr, bigEndianBytes, bigEndianBits);
+                if (status)
+                {
+                    // record where raw data came from so it can be downloaded again
+                    status = HexImage::UpdateInfo(hexfileName, format, loAddr, hiAddr - loAddr + 1, err);
+                }
 
                 progressGauge->EndProgress();
                 delete progressGauge;
@@ -356,8 +831,12 @@ bool FlashPort::UploadFlash( ostream& os,	///< dump uploaded data to this stream
 
 	assert(progressGauge != NULL);	//	make sure progress indicator is initialized
 	progressGauge->Report(0);	// start progress indicator at zero
-	
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
 	// read hex records from Flash and place data in the hex file
+	// the records are written to the stream by another thread while the next ones are read
+	UploadPipe pipe(os,format);
 	HexRecord hx;
 	hx.Setup(format);
 	unsigned long addr;
@@ -367,11 +846,7 @@ bool FlashPort::UploadFlash( ostream& os,	///< dump uploaded data to this stream
     for (addr = loAddr; (addr | 0xF) <= hiAddr; addr = (addr + 16) & ~0xF)
 	{
          // get 16 bytes from RAM
-        if (UploadHexRecordFromFlash(hx, addr, addr | 0xF, bigEndianBytes, bigEndianBits))
-        {
-            os << hx;		// send hex record to output stream
-        }
-        else
+        if (!UploadHexRecordFromFlash(hx, addr, addr | 0xF, bigEndianBytes, bigEndianBits) || !pipe.Write(hx))
         {
             status = false;
             break;
@@ -381,17 +856,28 @@ bool FlashPort::UploadFlash( ostream& os,	///< dump uploaded data to this stream
 
     if (status)
     {
-        if (addr < hiAddr)
+        if (addr <= hiAddr)
         {
             // handle the last few bytes of an upload
             status = UploadHexRecordFromFlash(hx,addr,hiAddr,bigEndianBytes,bigEndianBits);
             if (status)
             {
-                os << hx;		// send hex record to output stream
+                status = pipe.Write(hx);		// send hex record to output stream
             }
         }
 	}
 	progressGauge->Report(hiAddr);	// should set gauge to 100%
+	if (!pipe.Finish())
+	{
+		err.SetSeverity(XSErrorMajor);
+		err << "could not write the uploaded Flash data\n";
+		err.EndMsg();
+		status = false;
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	uploadRate = (seconds > 0) ? (hiAddr - loAddr + 1) / seconds : 0;
+	DEBUG_STMT("Flash upload " << (long)uploadRate << " bytes/s")
 	
     return status;
 }
@@ -23,6 +23,7 @@
 
 #include "progress.h"
 #include "hexrecrd.h"
+#include "heximage.h"
 #include "pport.h"
 
 
@@ -33,6 +34,26 @@
 #define ENDIAN_DEFAULTS	BIG_ENDIAN_BYTES,LITTLE_ENDIAN_BITS
 
 
+/// A run of equal-sized erasable sectors in a Flash chip.
+struct FlashSectorRun
+{
+	unsigned int count;		///< number of sectors in the run, or 0 at the end of the layout
+	unsigned int length;	///< bytes in each sector
+};
+
+
+/// Programming features of a type of Flash chip.
+struct FlashType
+{
+	unsigned int manufacturerId;	///< manufacturer code read in autoselect mode
+	unsigned int deviceId;			///< device code read in autoselect mode
+	const char* name;				///< part name
+	bool unlockBypass;				///< true if the chip accepts the two-cycle unlock bypass program command
+	unsigned int writeBufferSize;	///< bytes in the write buffer, or 0 if the chip has none
+	const FlashSectorRun* sectors;	///< sectors from address 0 upward, or NULL if the layout isn't known
+};
+
+
 /**
 Uploading and downloading of hexadecimal records to the Flash memory on an XSA, XSB or XSV Board.
 
@@ -53,11 +74,38 @@ of its current state through the parallel port status lines so the
 download method can detect any loss of synchronization during the Flash 
 download. 
 
+When the Flash is to be erased and the sector layout of the chip is 
+known, the download is done as an incremental update instead of a 
+full-chip erase. The layout is taken from the table of Flash types for 
+the chip identified by its autoselect codes, so chips that aren't in the 
+table, or whose size the table doesn't give, are always fully erased. The whole hex file is read first. For each block it touches, the 
+bytes given in the file are read back and compared with the file. Only 
+blocks that differ are erased and programmed, and the other blocks are 
+left alone. Setting the XSTOOLS parameter FLASHINCREMENTAL to NO restores 
+the full-chip erase. 
+
+Bytes are only programmed if they change the Flash. Bytes of 0xFF are 
+never programmed, since that is the value an erased byte already holds. 
+If a changed block only needs bits cleared, it is not erased and only 
+the bytes that differ are programmed. The numbers of bytes programmed 
+and skipped by the last download, and the rate at which the hex data 
+was loaded, can be read with GetBytesProgrammed(), GetBytesSkipped() 
+and GetDownloadRate(). 
+
+Before programming, the chip is identified from its autoselect codes and 
+looked up in a table of Flash types. Chips that support them are 
+programmed using the unlock bypass commands, which need two bus cycles 
+per byte instead of four, or by loading their write buffer with a run of 
+bytes at once. Setting the XSTOOLS parameter FLASHFASTPROGRAM to NO 
+programs every byte with the full unlock sequence. 
+
 The upload method works in a similar fashion. It passes an address 
 through the parallel port to the state machine in the XS Board FPGA or 
 CPLD. The CPLD returns the data from the given Flash memory address 
 while the upload method is sending the next memory address. 
 
+The transfer rate of the last upload can be read with GetUploadRate(). 
+
 */
 class FlashPort : public PPort
 {
@@ -101,6 +149,12 @@ class FlashPort : public PPort
 		bool bigEndianBits,
 		bool doErase);
 
+	bool DownloadFlash(
+		const HexImage& image,
+		bool bigEndianBytes,
+		bool bigEndianBits,
+		bool doErase);
+
 	bool DownloadHexRecordToFlash(
 		HexRecord& hx,
 		bool bigEndianBytes,
@@ -143,6 +197,14 @@ class FlashPort : public PPort
 
 	int Test(void);
 
+	unsigned long GetBytesProgrammed(void) const;
+
+	unsigned long GetBytesSkipped(void) const;
+
+	double GetDownloadRate(void) const;
+
+	double GetUploadRate(void) const;
+
 	virtual bool ProgramFlash(
 		unsigned int address,
 		unsigned int data,
@@ -153,13 +215,54 @@ class FlashPort : public PPort
 
 	virtual bool EraseFlashBlock(unsigned int blockIndex) = 0;
 
+	virtual unsigned int GetNumFlashBlocks(void);
+
+	virtual bool GetFlashBlock(unsigned int blockIndex, unsigned int* address, unsigned int* length);
+
 	virtual bool ResetFlash(void) = 0;
 
+	virtual bool ReadFlashId(unsigned int* manufacturerId, unsigned int* deviceId);
+
+	virtual bool StartProgramming(void);
+
+	virtual bool EndProgramming(void);
+
+	virtual bool ProgramFlashBuffer(
+		unsigned int address,
+		const unsigned char* data,
+		unsigned int length,
+		bool bigEndianBytes,
+		bool bigEndianBits);
+
+	const FlashType* GetFlashType(void);
+
+	bool IsFastProgram(void);
+
+	static const FlashType* FindFlashType(unsigned int manufacturerId, unsigned int deviceId);
+
 	
 	private:
 
+	bool DownloadImage(const HexImage& image, unsigned long gaugeEnd, bool bigEndianBytes, bool bigEndianBits, bool doErase);
+
+	bool IsIncremental(bool doErase);
+
+	bool UpdateFlash(const HexImage& hexImage, unsigned long gaugeEnd, bool bigEndianBytes, bool bigEndianBits);
+
+	bool ProgramFlashBytes(unsigned int address, const unsigned char* data, unsigned int length, bool erased, bool bigEndianBytes, bool bigEndianBits);
+
 	Progress *progressGauge;	// indicates progress of operations
 
+	unsigned long bytesProgrammed;	///< bytes written to the Flash by the last download
+	unsigned long bytesSkipped;		///< bytes of the last download that already held the right value
+	double downloadRate;			///< bytes of hex data per second for the last download
+
+	const FlashType* flashType;		///< type of the Flash chip, or NULL if it isn't known
+	bool flashTypeRead;				///< true once the chip has been identified
+	bool fastProgram;				///< false if the chip is only programmed with the basic commands
+
+	double uploadRate;			///< bytes per second for the last upload
+
 	unsigned int posRESET; // bit position in parallel port of RAM RESET pin
 	unsigned int posCLK;   // bit position in parallel port of RAM CLK pin
 	unsigned int posDOLSB; // bit position in parallel port of LSB of RAM data-out pin
@@ -24,9 +24,28 @@ void GuiTools::EnableBatch(bool b) ///< true if user prompts should be disabled
     batch = b;
 }
 
+/// Run a function on the GUI thread and wait for it to finish.
+/// The function is called directly if this is already the GUI thread.
+void GuiTools::RunOnGuiThread(std::function<void()> f)	///< function that creates or changes widgets
+{
+    QCoreApplication *app = QCoreApplication::instance();
+
+    if (NULL == app || QThread::currentThread() == app->thread())
+    {
+        f();
+    }
+    else
+    {
+        QMetaObject::invokeMethod(app, f, Qt::BlockingQueuedConnection);
+    }
+}
+
 void GuiTools::TellUser(const char *Msg)
 {
-    QMessageBox::critical(NULL, "Information", Msg, QMessageBox::Ok);
+    RunOnGuiThread([&]()
+    {
+        QMessageBox::critical(NULL, "Information", Msg, QMessageBox::Ok);
+    });
 }
 
 /// Subroutine for prompting the user for a response.
@@ -36,18 +55,25 @@ int GuiTools::PromptUser(string& msg, int action)
     if(batch)
         return RESPONSE_CONTINUE;
 
-    switch(action)
+    int response = RESPONSE_CONTINUE;
+
+    RunOnGuiThread([&]()
     {
-        case PROMPT_OKCANCEL:
-            QMessageBox::StandardButton Reply;
-            Reply = QMessageBox::information(NULL, "Information", msg.c_str(), QMessageBox::Ok | QMessageBox::Cancel);
-            return Reply == QMessageBox::Cancel ? RESPONSE_CANCEL : RESPONSE_CONTINUE;
-
-        case PROMPT_OK:
-        default:
-            QMessageBox::information(NULL, "Information", msg.c_str(), QMessageBox::Ok);
-            return RESPONSE_CONTINUE;
-    }
+        switch(action)
+        {
+            case PROMPT_OKCANCEL:
+                QMessageBox::StandardButton Reply;
+                Reply = QMessageBox::information(NULL, "Information", msg.c_str(), QMessageBox::Ok | QMessageBox::Cancel);
+                response = (Reply == QMessageBox::Cancel ? RESPONSE_CANCEL : RESPONSE_CONTINUE);
+                break;
+
+            case PROMPT_OK:
+            default:
+                QMessageBox::information(NULL, "Information", msg.c_str(), QMessageBox::Ok);
+                break;
+        }
+    });
+    return response;
 }
 
 
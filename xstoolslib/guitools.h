@@ -2,6 +2,7 @@
 #define GUITOOLS_H
 
 #include <QtWidgets>
+#include <functional>
 
 #include "xsboard.h"
 
@@ -17,6 +18,9 @@ public:
     static void SetBoardList(QComboBox *cb);
     static bool GetPortTypeAndNumber(QComboBox *cb, PortType *portType, int *portNum);
 
+    /// Run a function on the GUI thread and wait for it to finish (needed for dialogs shown from the I/O thread).
+    static void RunOnGuiThread(std::function<void()> f);
+
     static void TellUser(const char *Msg);
 
     /// Subroutine for prompting the user for a response.
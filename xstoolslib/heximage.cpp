@@ -0,0 +1,627 @@
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "utils.h"
+#include "parameters.h"
+#include "heximage.h"
+
+
+static const unsigned long minParallelPiece = 0x100000;	// smallest piece of a hex file worth decoding on its own core
+
+
+/// Values of the hex digit characters, or -1 for characters that aren't hex digits.
+static struct HexDigitTable
+{
+	signed char value[256];
+
+	HexDigitTable(void)
+	{
+		memset(value,-1,sizeof(value));
+		for(int i=0; i<10; i++)
+			value['0'+i] = i;
+		for(int i=0; i<6; i++)
+		{
+			value['A'+i] = 10+i;
+			value['a'+i] = 10+i;
+		}
+	}
+} hexDigits;
+
+
+/// Decoded data and the state at the end of one piece of a hex file.
+struct HexPiece
+{
+	const unsigned char* begin;		///< first character of the piece
+	const unsigned char* end;		///< character after the last one in the piece
+	vector<HexImage::Record> records;	///< data records, with data pointers filled in after decoding
+	vector<unsigned long> dataIndex;	///< index of each record's data in bytes
+	vector<bool> relative;			///< true for Intel records that come before any base address in the piece
+	vector<unsigned char> bytes;	///< decoded data bytes of all the records
+	bool baseSet;					///< true if the piece sets the Intel base address
+	unsigned long base;				///< Intel base address at the end of the piece
+	HexRecordError error;			///< first error found in the piece
+	const unsigned char* errorPos;	///< start of the record with the error
+};
+
+
+/// Skip whitespace and get a field of hex digits.
+///\return true if all the digits were there, false if not
+static inline bool GetHexField(const unsigned char*& p,	///< position in the text, moved past the field
+				const unsigned char* end,	///< end of the text
+				unsigned int numDigits,		///< number of hex digits in the field
+				unsigned long* value)		///< returns the value of the field
+{
+	while(p<end && isspace(*p))
+		p++;
+	if((unsigned long)(end-p) < numDigits)
+		return false;
+	unsigned long v = 0;
+	for(unsigned int i=0; i<numDigits; i++)
+	{
+		int d = hexDigits.value[*p++];
+		if(d < 0)
+			return false;
+		v = (v<<4) | d;
+	}
+	*value = v;
+	return true;
+}
+
+
+/// Decode the hex records in a piece of a hex file.
+static void DecodePiece(HexPiece* piece)	///< piece to decode, with begin and end already set
+{
+	const unsigned char* p = piece->begin;
+	const unsigned char* end = piece->end;
+	unsigned long base = 0;
+	piece->baseSet = false;
+	piece->error = NoHexRecordError;
+
+	while(true)
+	{
+		while(p<end && isspace(*p))
+			p++;
+		if(p >= end)
+			break;
+
+		const unsigned char* start = p;
+		unsigned long length, address, type, value;
+		unsigned int addrLength;	// bytes in the address field
+		unsigned int sum;			// sum of the bytes covered by the checksum
+		bool isData;
+		HexRecordError error = NoHexRecordError;
+		char tag = *p++;
+		switch(tag)
+		{
+		case ':':	// Intel
+			if(!GetHexField(p,end,2,&length))					{ error = LengthHexRecordError; break; }
+			if(!GetHexField(p,end,4,&address))					{ error = AddressHexRecordError; break; }
+			if(!GetHexField(p,end,2,&type))						{ error = TypeHexRecordError; break; }
+			sum = length + (address>>8) + (address&0xFF) + type;
+			addrLength = 2;
+			isData = (type == 0x00);
+			break;
+		case 'S':	// Motorola
+			if(p >= end)										{ error = StartHexRecordError; break; }
+			type = *p++;
+			switch(type)
+			{
+			case '0': case '1': case '9':	addrLength = 2;	break;
+			case '2': case '8':				addrLength = 3;	break;
+			case '3': case '7':				addrLength = 4;	break;
+			default:						error = StartHexRecordError;	break;
+			}
+			if(error != NoHexRecordError)
+				break;
+			if(!GetHexField(p,end,2,&length) || length<addrLength+1)	{ error = LengthHexRecordError; break; }
+			sum = length;
+			length -= addrLength+1;		// count covered the address and checksum too
+			if(!GetHexField(p,end,2*addrLength,&address))		{ error = AddressHexRecordError; break; }
+			for(unsigned int i=0; i<addrLength; i++)
+				sum += (address>>(8*i)) & 0xFF;
+			isData = (type>='1' && type<='3');
+			break;
+		case '-':	// XESS with 16, 24 or 32-bit address
+		case '=':
+		case '+':
+			addrLength = (tag=='-') ? 2 : (tag=='=') ? 3 : 4;
+			if(!GetHexField(p,end,2,&length))					{ error = LengthHexRecordError; break; }
+			if(!GetHexField(p,end,2*addrLength,&address))		{ error = AddressHexRecordError; break; }
+			sum = 0;
+			isData = true;
+			break;
+		default:
+			error = StartHexRecordError;
+			break;
+		}
+
+		// decode the data bytes straight into the piece
+		unsigned long dataIndex = piece->bytes.size();
+		if(error == NoHexRecordError)
+		{
+			piece->bytes.resize(dataIndex+length);
+			unsigned char* data = &piece->bytes[0] + dataIndex;
+			for(unsigned long i=0; i<length; i++)
+			{
+				if(!GetHexField(p,end,2,&value))
+				{
+					error = DataHexRecordError;
+					break;
+				}
+				data[i] = value;
+				sum += value;
+			}
+		}
+
+		// check the checksum of Intel and Motorola records
+		if(error==NoHexRecordError && tag!='-' && tag!='=' && tag!='+')
+		{
+			if(!GetHexField(p,end,2,&value))
+				error = CheckSumHexRecordError;
+			else if(tag==':' && ((sum+value) & 0xFF)!=0)
+				error = CheckSumHexRecordError;
+			else if(tag=='S' && ((~sum) & 0xFF)!=value)
+				error = CheckSumHexRecordError;
+		}
+
+		if(error != NoHexRecordError)
+		{
+			piece->error = error;
+			piece->errorPos = start;
+			return;
+		}
+
+		if(tag==':' && (type==0x02 || type==0x04))
+		{ // Intel extended segment or linear address
+			if(length < 2)
+			{
+				piece->error = DataHexRecordError;
+				piece->errorPos = start;
+				return;
+			}
+			const unsigned char* data = &piece->bytes[dataIndex];
+			base = ((data[0]<<8) + data[1]) << (type==0x02 ? 4 : 16);
+			piece->baseSet = true;
+		}
+
+		if(!isData || length==0)
+		{
+			piece->bytes.resize(dataIndex);	// drop the bytes of records that don't hold data
+			continue;
+		}
+
+		HexImage::Record r;
+		r.address = (tag==':') ? base+address : address;
+		r.data = NULL;
+		r.length = length;
+		piece->records.push_back(r);
+		piece->dataIndex.push_back(dataIndex);
+		piece->relative.push_back(tag==':' && !piece->baseSet);
+	}
+	piece->base = base;
+}
+
+
+/// Create an empty hex image.
+HexImage::HexImage(void)
+{
+	numBytes = 0;
+}
+
+
+/// Remove all the data from the image.
+void HexImage::Clear(void)
+{
+	extents.clear();
+	numBytes = 0;
+}
+
+
+/// Check if a file holds hex records rather than something else, such as a Xilinx bitstream.
+///\return true if the file starts with an Intel, Motorola or XESS hex record
+bool HexImage::IsHexFile(const char* fileName)	///< name of the file to check
+{
+	ifstream is(fileName, ios::binary);
+	char c;
+	if(!(is >> c))
+		return false;
+	return c==':' || c=='S' || c=='-' || c=='=' || c=='+';
+}
+
+
+/// Check if a file holds raw binary data.
+///\return true if the file has an info file or a .BIN suffix
+bool HexImage::IsBinaryFile(const char* fileName)	///< name of the file to check
+{
+	if(strlen(fileName) == 0)
+		return false;
+	ifstream is(InfoFileName(fileName).c_str());
+	return is.is_open() || GetSuffix(fileName)=="BIN";
+}
+
+
+/// Check if a file can be loaded into an image.
+///\return true if the file holds raw binary data or hex records
+bool HexImage::CanLoad(const char* fileName)	///< name of the file to check
+{
+	return IsBinaryFile(fileName) || IsHexFile(fileName);
+}
+
+
+/// Get the name of the info file that goes with a binary file.
+///\return the name of the binary file with .INF added
+string HexImage::InfoFileName(const char* fileName)	///< name of the binary file
+{
+	return string(fileName) + ".INF";
+}
+
+
+/// Write the info file that records where the data in an uploaded binary file goes.
+/// If the file was uploaded in some other format, any info file left from an earlier
+/// binary upload is removed so the file isn't mistaken for a binary file.
+///\return true if the info file was written or isn't needed, false if there was an error
+bool HexImage::UpdateInfo(const char* fileName,	///< name of the uploaded file
+				const char* format,		///< format the file was written in
+				unsigned long address,	///< address of the first byte in the file
+				unsigned long length,	///< number of bytes in the file
+				XSError& err)			///< error reporting object
+{
+	string infoFileName = InfoFileName(fileName);
+	if(!IsBinaryFormat(format))
+	{
+		remove(infoFileName.c_str());	// usually there isn't one
+		return true;
+	}
+
+	ofstream os(infoFileName.c_str());
+	os << "ADDRESS " << hex << address << "\n";
+	os << "LENGTH " << hex << length << "\n";
+	os.close();
+	if(os.fail())
+	{
+		err.SetSeverity(XSErrorMajor);
+		err << "could not write " << infoFileName << "\n";
+		err.EndMsg();
+		return false;
+	}
+	return true;
+}
+
+
+/// Get the address and length of the data in a binary file from its info file.
+///\return true if the info was found, false if there was an error in the info file
+bool HexImage::LoadInfo(const char* fileName,	///< name of the binary file
+				unsigned long* address,	///< returns the address of the first byte
+				unsigned long* length,	///< returns the number of bytes to use, or ULONG_MAX for the whole file
+				XSError& err)			///< error reporting object
+{
+	*address = 0;
+	*length = ULONG_MAX;
+
+	string infoFileName = InfoFileName(fileName);
+	ifstream is(infoFileName.c_str());
+	if(!is)
+	{ // no info file, so the address can come from the parameters
+		string param = Parameters::GetXSTOOLSParameter("BINADDRESS");
+		if(param != "")
+			*address = strtoul(param.c_str(),NULL,16);
+		return true;
+	}
+
+	string key, value;
+	while(is >> key >> value)
+	{
+		char* end;
+		unsigned long v = strtoul(value.c_str(),&end,16);
+		if(*end != '\0')
+		{
+			err.SetSeverity(XSErrorMajor);
+			err << "invalid value for " << key << " in " << infoFileName << "\n";
+			err.EndMsg();
+			return false;
+		}
+		key = ConvertToUpperCase(key);
+		if(key == "ADDRESS")
+			*address = v;
+		else if(key == "LENGTH")
+			*length = v;
+	}
+	return true;
+}
+
+
+/// Load the data from a hex or binary file.
+///\return true if the file was loaded, false if there was an error
+bool HexImage::Load(const char* fileName,	///< name of the hex or binary file
+				XSError& err)			///< error reporting object
+{
+	Clear();
+
+	bool binary = IsBinaryFile(fileName);
+	unsigned long address, length;
+	if(binary && !LoadInfo(fileName,&address,&length,err))
+		return false;
+
+#ifndef _WIN32
+	int fd = open(fileName, O_RDONLY);
+	if(fd < 0)
+	{
+		err.SetSeverity(XSErrorMajor);
+		err << "could not open " << fileName << "\n";
+		err.EndMsg();
+		return false;
+	}
+	struct stat info;
+	if(fstat(fd,&info) != 0)
+	{
+		close(fd);
+		err.SetSeverity(XSErrorMajor);
+		err << "could not get the size of " << fileName << "\n";
+		err.EndMsg();
+		return false;
+	}
+	if(info.st_size == 0)
+	{
+		close(fd);
+		return true;	// an empty file is just an empty image
+	}
+	void* text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(text == MAP_FAILED)
+	{
+		err.SetSeverity(XSErrorMajor);
+		err << "could not map " << fileName << " into memory\n";
+		err.EndMsg();
+		return false;
+	}
+	madvise(text, info.st_size, MADV_SEQUENTIAL);
+	bool status = true;
+	if(binary)
+		SetData(address, (const unsigned char*)text, min(length,(unsigned long)info.st_size));
+	else
+		status = Parse((const char*)text, info.st_size, err);
+	munmap(text, info.st_size);
+	return status;
+#else
+	ifstream is(fileName, ios::binary);
+	if(!is)
+	{
+		err.SetSeverity(XSErrorMajor);
+		err << "could not open " << fileName << "\n";
+		err.EndMsg();
+		return false;
+	}
+	vector<char> text((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+	if(text.empty())
+		return true;
+	if(binary)
+	{
+		SetData(address, (const unsigned char*)&text[0], min(length,(unsigned long)text.size()));
+		return true;
+	}
+	return Parse(&text[0], text.size(), err);
+#endif
+}
+
+
+/// Decode the hex records in a block of text.
+///\return true if all the records were decoded, false if there was an error
+bool HexImage::Parse(const char* text,	///< text of the hex file
+				unsigned long length,	///< number of characters in the text
+				XSError& err)			///< error reporting object
+{
+	Clear();
+
+	// split big files into pieces at line boundaries to decode them in parallel
+	unsigned int numPieces = 1;
+	if(Parameters::GetXSTOOLSParameter("HEXPARALLEL") != "NO")
+	{
+		unsigned int numCores = thread::hardware_concurrency();
+		numPieces = max(1U, min(numCores, (unsigned int)(length/minParallelPiece)));
+	}
+	const unsigned char* begin = (const unsigned char*)text;
+	const unsigned char* end = begin + length;
+	vector<HexPiece> pieces(numPieces);
+	const unsigned char* p = begin;
+	for(unsigned int i=0; i<numPieces; i++)
+	{
+		pieces[i].begin = p;
+		if(i == numPieces-1)
+			p = end;
+		else
+		{
+			p = max(p, begin + length/numPieces*(i+1));
+			p = (const unsigned char*)memchr(p, '\n', end-p);
+			p = (p==NULL) ? end : p+1;
+		}
+		pieces[i].end = p;
+	}
+
+	if(numPieces == 1)
+		DecodePiece(&pieces[0]);
+	else
+	{
+		vector<thread> decoders;
+		for(unsigned int i=0; i<numPieces; i++)
+			decoders.push_back(thread(DecodePiece,&pieces[i]));
+		for(unsigned int i=0; i<numPieces; i++)
+			decoders[i].join();
+	}
+
+	// report the first error in the file
+	for(unsigned int i=0; i<numPieces; i++)
+	{
+		if(pieces[i].error != NoHexRecordError)
+		{
+			long line = 1 + count(begin, pieces[i].errorPos, '\n');
+			err.SetSeverity(XSErrorMajor);
+			err << "hex record at line " << line << ": " << ErrMsg(pieces[i].error) << "\n";
+			err.EndMsg();
+			return false;
+		}
+	}
+
+	// carry the Intel base address from each piece into the next and collect the records in file order
+	vector<Record> records;
+	unsigned long base = 0;
+	for(unsigned int i=0; i<numPieces; i++)
+	{
+		HexPiece& piece = pieces[i];
+		for(unsigned int j=0; j<piece.records.size(); j++)
+		{
+			Record r = piece.records[j];
+			r.data = &piece.bytes[piece.dataIndex[j]];
+			if(piece.relative[j])
+				r.address += base;
+			records.push_back(r);
+		}
+		if(piece.baseSet)
+			base = piece.base;
+	}
+
+	BuildExtents(records);
+	return true;
+}
+
+
+/// Collect the data records from a stream of hex records.
+///\return true if all the records were read, false if there was an error
+bool HexImage::Read(istream& is,	///< stream that delivers hex records
+				XSError& err)	///< error reporting object
+{
+	Clear();
+
+	vector<Record> records;
+	vector<unsigned char> bytes;
+	vector<unsigned long> dataIndex;
+	HexRecord hx;
+	while(is.eof()==0)
+	{
+		is >> hx;
+		if(is.eof()!=0)
+			break; // terminate loading loop when stream goes dry
+		if(is.fail() || err.IsError())
+		{
+			err.SetSeverity(XSErrorMajor);
+			err << "error reading stream\n";
+			err.EndMsg();
+			return false;
+		}
+		if(hx.IsError())
+		{ // some error in the hex record itself
+			err.SetSeverity(XSErrorMajor);
+			err << "hex record: " << hx.GetErrMsg() << "\n";
+			err.EndMsg();
+			return false;
+		}
+		if(!hx.IsData() || hx.GetLength()==0)
+			continue;
+
+		Record r;
+		r.address = hx.GetAddress();
+		r.data = NULL;
+		r.length = hx.GetLength();
+		records.push_back(r);
+		dataIndex.push_back(bytes.size());
+		for(unsigned int i=0; i<hx.GetLength(); i++)
+			bytes.push_back(hx[i]);
+	}
+	for(unsigned int j=0; j<records.size(); j++)
+		records[j].data = &bytes[dataIndex[j]];
+
+	BuildExtents(records);
+	return true;
+}
+
+
+/// Replace the contents of the image with a single run of bytes.
+void HexImage::SetData(unsigned long address,	///< address of the first byte
+				const unsigned char* data,	///< data bytes
+				unsigned long length)		///< number of data bytes
+{
+	Clear();
+	if(length == 0)
+		return;
+	extents.push_back(HexExtent());
+	extents.back().address = address;
+	extents.back().data.assign(data,data+length);
+	numBytes = length;
+}
+
+
+/// Arrange the data records into sorted extents of consecutive bytes.
+void HexImage::BuildExtents(const vector<Record>& records)	///< data records in the order they appear in the file
+{
+	// find the address ranges covered by the records
+	vector<unsigned int> order(records.size());
+	for(unsigned int i=0; i<order.size(); i++)
+		order[i] = i;
+	sort(order.begin(), order.end(),
+		[&records](unsigned int a, unsigned int b) { return records[a].address < records[b].address; });
+
+	extents.clear();
+	unsigned long extentEnd = 0;	// address just past the last extent
+	for(unsigned int i=0; i<order.size(); i++)
+	{
+		const Record& r = records[order[i]];
+		if(extents.empty() || r.address > extentEnd)
+		{
+			extents.push_back(HexExtent());
+			extents.back().address = r.address;
+			extentEnd = r.address;
+		}
+		extentEnd = max(extentEnd, r.address + r.length);
+		extents.back().data.resize(extentEnd - extents.back().address);
+	}
+
+	// fill the extents in file order so later records overwrite earlier ones
+	numBytes = 0;
+	for(unsigned int i=0; i<records.size(); i++)
+	{
+		const Record& r = records[i];
+		unsigned int e = upper_bound(extents.begin(), extents.end(), r.address,
+			[](unsigned long addr, const HexExtent& x) { return addr < x.address; }) - extents.begin() - 1;
+		memcpy(&extents[e].data[r.address - extents[e].address], r.data, r.length);
+	}
+	for(unsigned int e=0; e<extents.size(); e++)
+		numBytes += extents[e].data.size();
+}
+
+
+/// Get the number of extents in the image.
+///\return the number of runs of consecutive bytes
+unsigned int HexImage::GetNumExtents(void) const
+{
+	return extents.size();
+}
+
+
+/// Get an extent of the image.
+///\return the run of consecutive bytes with the given index, in order of address
+const HexExtent& HexImage::GetExtent(unsigned int i) const	///< index of the extent
+{
+	assert(i < extents.size());
+	return extents[i];
+}
+
+
+/// Get the number of data bytes in the image.
+///\return the number of bytes in all the extents
+unsigned long HexImage::GetNumBytes(void) const
+{
+	return numBytes;
+}
@@ -0,0 +1,105 @@
+#ifndef HEXIMAGE_H
+#define HEXIMAGE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "xserror.h"
+#include "hexrecrd.h"
+
+
+/// A run of consecutive bytes in a hex image.
+struct HexExtent
+{
+	unsigned long address;			///< address of the first byte
+	vector<unsigned char> data;		///< bytes starting at the address
+};
+
+
+/**
+The data from a hex file as a sparse memory image.
+
+This object collects the data records of an Intel, Motorola or XESS hex
+file into a list of extents, each holding a run of consecutive bytes.
+The extents are sorted by address and don't overlap or touch, so each
+one can be written to the board as a single block. Where records in the
+file overlap, the record that comes later in the file wins, as it would
+if the records were downloaded one after another.
+
+Load() maps the file into memory and decodes it directly with a table
+of hex digit values instead of reading it a character at a time through
+a stream. The checksum of every Intel and Motorola record is checked as
+it is decoded. Files bigger than a few megabytes are split at line
+boundaries and the pieces are decoded on several cores at once, unless
+the XSTOOLS parameter HEXPARALLEL is NO. Intel extended address records
+carry over from one piece to the next.
+
+Read() builds the same image from a stream of hex records, for data
+that doesn't come from a hex file.
+
+Binary files hold raw data bytes for a single range of addresses. 
+Load() maps them into memory as one extent. The address of the first 
+byte is taken from an info file with the same name plus .INF, which has 
+lines like "ADDRESS 1000" and "LENGTH 8000" with hex values. Uploads in 
+the BIN format write this file whatever the suffix of the uploaded file, 
+and uploads in other formats remove a stale one. A file is binary if it 
+has an info file or a .BIN suffix. If there is no info file, the address 
+is the hex value of the XSTOOLS parameter BINADDRESS, or 0 if that isn't 
+set.
+
+*/
+class HexImage
+{
+	public:
+
+	HexImage(void);
+
+	void Clear(void);
+
+	static bool IsHexFile(const char* fileName);
+
+	static bool IsBinaryFile(const char* fileName);
+
+	static bool CanLoad(const char* fileName);
+
+	static string InfoFileName(const char* fileName);
+
+	static bool UpdateInfo(const char* fileName, const char* format, unsigned long address, unsigned long length, XSError& err);
+
+	bool Load(const char* fileName, XSError& err);
+
+	bool Parse(const char* text, unsigned long length, XSError& err);
+
+	bool Read(istream& is, XSError& err);
+
+	void SetData(unsigned long address, const unsigned char* data, unsigned long length);
+
+	unsigned int GetNumExtents(void) const;
+
+	const HexExtent& GetExtent(unsigned int i) const;
+
+	unsigned long GetNumBytes(void) const;
+
+
+	/// Data record found while decoding a hex file.
+	struct Record
+	{
+		unsigned long address;		///< address of the first data byte
+		const unsigned char* data;	///< decoded data bytes
+		unsigned int length;		///< number of data bytes
+	};
+
+
+	private:
+
+	static bool LoadInfo(const char* fileName, unsigned long* address, unsigned long* length, XSError& err);
+
+	void BuildExtents(const vector<Record>& records);
+
+	vector<HexExtent> extents;	///< runs of data bytes, sorted by address
+	unsigned long numBytes;		///< number of data bytes in all the extents
+};
+
+#endif
@@ -22,6 +22,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
 #include <string.h>
 
@@ -99,6 +100,11 @@ void HexRecord::Setup(const char* format)  ///< string that indicates hex file f
 			SetFileFormat(XilinxFormat);
 			SetRecordType(XilinxDataRecord);
 		}
+		else if(!strcmp(format,"BIN"))
+		{
+			SetFileFormat(BinaryFormat);
+			SetRecordType(BinaryDataRecord);
+		}
 		else
 		{
 			assert(1==0);	// should never get here
@@ -182,6 +188,7 @@ void HexRecord::SetRecordType(HexRecordType t) ///< type of hex record
 		mask = 0x0000FFFF;
 		break;
 	case XilinxDataRecord:
+	case BinaryDataRecord:
 		segmented = false;
 		mask = 0xFFFFFFFF;
 		break;
@@ -213,6 +220,7 @@ bool HexRecord::IsData(void) const
 	case XESSDataWith24BitAddressRecord:
 	case XESSDataWith32BitAddressRecord:
 	case XilinxDataRecord:
+	case BinaryDataRecord:
 		return true;
 	default:
 		return false;
@@ -258,6 +266,7 @@ void HexRecord::SetAddress(unsigned int addr)
 	case XESSDataWith24BitAddressRecord:
 	case XESSDataWith32BitAddressRecord:
 	case XilinxDataRecord:
+	case BinaryDataRecord:
 		offset = addr;
 		base = 0;
 		break;
@@ -298,6 +307,7 @@ unsigned int HexRecord::GetAddress(void) const
 	case XESSDataWith24BitAddressRecord:
 	case XESSDataWith32BitAddressRecord:
 	case XilinxDataRecord:
+	case BinaryDataRecord:
 		return offset;
 		break;
 	case IntelDataRecord:
@@ -372,6 +382,7 @@ unsigned int HexRecord::GetAddressLength(void)
 	case XESSDataWith24BitAddressRecord:	return 3;
 	case XESSDataWith32BitAddressRecord:	return 4;
 	case XilinxDataRecord:					return 4;
+	case BinaryDataRecord:					return 4;
 	default:
 		assert(1==0);
 		return 0;
@@ -436,6 +447,7 @@ void HexRecord::CalcCheckSum(void)
 		break;
 	case XESSFormat:
 	case XilinxFormat:
+	case BinaryFormat:
 	case UnknownFormat:
 		checkSum = 0;
 		break;
@@ -508,6 +520,14 @@ const char* ErrMsg(HexRecordError e)
 }
 
 
+/// Check if a file format holds raw data bytes instead of hex records.
+///\return true for the "BIN" format, which must be written to a file opened in binary mode
+bool IsBinaryFormat(const char* format)	///< string that indicates the file format (e.g., "BIN", "EXO-24", "MCS", etc.)
+{
+	return format!=NULL && !strcmp(format,"BIN");
+}
+
+
 /// Helper function to load a hex record from a stream.
 ///\return reference to the stream that delivers the hex record data
 istream& operator>> (istream& is, 	///< stream that delivers hex records
@@ -860,7 +880,60 @@ istream& operator>> (istream& is, 	///< stream that delivers hex records
 }
 
 
+static const char hexDigits[] = "0123456789ABCDEF";	// uppercase hex digit for each nybble value
+
+static const unsigned int maxLocalRecordChars = 1024;	// records shorter than this are formatted on the stack
+
+
+/// Layout of each type of Motorola and XESS hex record.
+static const struct
+{
+	HexRecordType type;			///< type of hex record
+	const char* tag;			///< characters at the start of the record
+	unsigned int addrDigits;	///< number of hex digits in the address
+} recordLayouts[] =
+{
+	{MotoDataWith16BitAddressRecord,	"S1",	4},
+	{MotoDataWith24BitAddressRecord,	"S2",	6},
+	{MotoDataWith32BitAddressRecord,	"S3",	8},
+	{MotoEndWith16BitAddressRecord,		"S9",	4},
+	{MotoEndWith24BitAddressRecord,		"S8",	6},
+	{MotoEndWith32BitAddressRecord,		"S7",	8},
+	{MotoStartRecord,					"S0",	4},
+	{XESSDataWith16BitAddressRecord,	"- ",	4},
+	{XESSDataWith24BitAddressRecord,	"= ",	6},
+	{XESSDataWith32BitAddressRecord,	"+ ",	8},
+};
+
+
+/// Put a value into a character buffer as uppercase hex digits.
+/// Like setw(), more digits are used if the value doesn't fit in the given number.
+///\return a pointer to the character after the last digit
+static char* PutHex(char* p,	///< where to put the digits
+				unsigned int value,		///< value to convert
+				unsigned int digits)	///< minimum number of digits
+{
+	while(digits<8 && (value>>(4*digits))!=0)
+		digits++;
+	while(digits-- > 0)
+		*p++ = hexDigits[(value>>(4*digits)) & 0xF];
+	return p;
+}
+
+
+/// Put a byte into a character buffer as two uppercase hex digits.
+///\return a pointer to the character after the last digit
+static inline char* PutHexByte(char* p,	///< where to put the digits
+				unsigned int b)		///< byte to convert
+{
+	*p++ = hexDigits[(b>>4) & 0xF];
+	*p++ = hexDigits[b & 0xF];
+	return p;
+}
+
+
 /// Helper function to output the hex record to a stream in Motorola, Intel, or XESS format.
+/// The whole record is formatted into a character buffer and sent to the stream with a single write.
 ///\return the output stream for the hex record data
 ostream& operator<< (ostream& os,	///< stream to which hex record is sent
 					HexRecord& hx)	///< hex record that is output through the stream
@@ -869,56 +942,63 @@ ostream& operator<< (ostream& os,	///< stream to which hex record is sent
 		return os;	// abort if hex record is not valid
 
 	unsigned int i;
+	unsigned int length = hx.GetLength();
+
+	if(hx.GetFileFormat() == BinaryFormat)
+	{ // raw data goes out as it is, so the address of each byte is given by its position in the file
+		if(length > 0)
+			os.write((const char*)&hx[0],length);
+		return os;
+	}
+
+	// get a buffer big enough for the longest record with this much data
+	char localBuf[maxLocalRecordChars];
+	vector<char> bigBuf;
+	char* buf = localBuf;
+	if(3*length+32 > maxLocalRecordChars)
+	{
+		bigBuf.resize(3*length+32);
+		buf = &bigBuf[0];
+	}
+	char* p = buf;
 
 	switch(hx.GetFileFormat())
 	{
 	case MotorolaFormat:
-		os << "S";
-		switch(hx.GetRecordType())
+	case XESSFormat:
+		for(i=0; i<sizeof(recordLayouts)/sizeof(recordLayouts[0]); i++)
 		{
-			case MotoDataWith16BitAddressRecord:
-				os << '1';
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+3;
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetAddress();
-				break;
-			case MotoDataWith24BitAddressRecord:
-				os << '2';
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+4;
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(6) << hex << hx.GetAddress();
-				break;
-			case MotoDataWith32BitAddressRecord:
-				os << '3';
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+5;
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(8) << hex << hx.GetAddress();
-				break;
-			case MotoEndWith16BitAddressRecord:
-				os << '9';
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+3;
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetAddress();
-				break;
-			case MotoEndWith24BitAddressRecord:
-				os << '8';
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+4;
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(6) << hex << hx.GetAddress();
-				break;
-			case MotoEndWith32BitAddressRecord:
-				os << '7';
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+5;
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(8) << hex << hx.GetAddress();
-				break;
-			case MotoStartRecord:
-				os << '0';
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength()+3;
-				os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetAddress();
-				break;
-			default:
-				assert(1==0);
+			if(recordLayouts[i].type == hx.GetRecordType())
 				break;
 		}
-		for(i=0; i<hx.GetLength(); i++)
-			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx[i];
-		os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx.GetCheckSum();
-		os << endl;
+		if(i == sizeof(recordLayouts)/sizeof(recordLayouts[0]))
+		{
+			assert(hx.GetFileFormat()==XESSFormat);	// an XESS record with no header just lists its data
+		}
+		else if(hx.GetFileFormat() == MotorolaFormat)
+		{
+			*p++ = recordLayouts[i].tag[0];
+			*p++ = recordLayouts[i].tag[1];
+			p = PutHex(p,length+recordLayouts[i].addrDigits/2+1,2);	// length includes address and checksum
+			p = PutHex(p,hx.GetAddress(),recordLayouts[i].addrDigits);
+		}
+		else
+		{
+			*p++ = recordLayouts[i].tag[0];
+			*p++ = recordLayouts[i].tag[1];
+			p = PutHex(p,length,2);
+			*p++ = ' ';
+			p = PutHex(p,hx.GetAddress(),recordLayouts[i].addrDigits);
+		}
+
+		for(i=0; i<length; i++)
+		{
+			if(hx.GetFileFormat() == XESSFormat)
+				*p++ = ' ';
+			p = PutHexByte(p,hx[i]);
+		}
+		if(hx.GetFileFormat() == MotorolaFormat)
+			p = PutHexByte(p,hx.GetCheckSum());
 		break;
 
 	case IntelFormat:
@@ -943,46 +1023,20 @@ ostream& operator<< (ostream& os,	///< stream to which hex record is sent
 			hx.SetBaseAddress(offset & ~0xFFFF);
 			hx.SetOffsetAddress(offset & 0xFFFF);
 		}
-		os << ":";
-		os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength();
-		os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetOffsetAddress();
-		os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (hx.GetRecordType() & 0x0F);
-		for(i=0; i<hx.GetLength(); i++)
-			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx[i];
-		os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx.GetCheckSum();
-		os << endl;
-		break;
-
-	case XESSFormat:
-		switch(hx.GetRecordType())
-		{
-		case XESSDataWith16BitAddressRecord:
-			os << "- ";
-			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength();
-			os << " ";
-			os << setiosflags(ios::uppercase) << setfill('0') << setw(4) << hex << hx.GetAddress();
-			break;
-		case XESSDataWith24BitAddressRecord:
-			os << "= ";
-			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength();
-			os << " ";
-			os << setiosflags(ios::uppercase) << setfill('0') << setw(6) << hex << hx.GetAddress();
-			break;
-		case XESSDataWith32BitAddressRecord:
-			os << "+ ";
-			os << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << hx.GetLength();
-			os << " ";
-			os << setiosflags(ios::uppercase) << setfill('0') << setw(8) << hex << hx.GetAddress();
-			break;
-		}
-		for(i=0; i<hx.GetLength(); i++)
-			os << " " << setiosflags(ios::uppercase) << setfill('0') << setw(2) << hex << (int)hx[i];
-		os << endl;
+		*p++ = ':';
+		p = PutHex(p,length,2);
+		p = PutHex(p,hx.GetOffsetAddress(),4);
+		p = PutHexByte(p,hx.GetRecordType() & 0x0F);
+		for(i=0; i<length; i++)
+			p = PutHexByte(p,hx[i]);
+		p = PutHexByte(p,hx.GetCheckSum());
 		break;
 
 	default:
 		assert(1==0);
 	}
+	*p++ = '\n';
 	
+	os.write(buf,p-buf);
 	return os;
 }
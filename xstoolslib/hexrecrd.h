@@ -24,6 +24,9 @@
 #include <iostream>
 
 
+#define HEX_FILE_BUFFER_SIZE	0x100000	// bytes buffered by streams that write hex files
+
+
 /**
 Supported hex file formats.
 
@@ -33,7 +36,9 @@ address in memory for the data. This object has methods for entering
 data, reading the data back, determining the type of the data and 
 setting/querying the starting address. Operators are also provided that 
 allow storing/loading of HexRecord objects to/from Intel, Motorola and 
-XESS HEX files. 
+XESS HEX files. Records in the BIN format are stored as raw data bytes 
+with no address, so they can only be written, one after another, for a 
+contiguous range of addresses. 
 
 */
 typedef enum
@@ -42,6 +47,7 @@ typedef enum
 	IntelFormat		= 0x10,	///< Intel MCS or HEX format
 	XESSFormat		= 0x20,	///< XESS XES format
 	XilinxFormat    = 0x30, ///< .bit format, not really a hex format
+	BinaryFormat    = 0x40, ///< raw data bytes, not really a hex format
 	UnknownFormat   = 0xF0,
 } HexFileFormat;
 
@@ -66,6 +72,7 @@ typedef enum
 	XESSDataWith24BitAddressRecord	= 0x21,	// actual address and data
 	XESSDataWith32BitAddressRecord	= 0x22,	// actual address and data
 	XilinxDataRecord                = 0x30, // bits in bitstream
+	BinaryDataRecord                = 0x40, // raw data bytes
 	InvalidRecord					= 0xFF,	// erroneous record
 } HexRecordType;
 
@@ -159,6 +166,7 @@ class HexRecord
 
 
 const char* ErrMsg(HexRecordError e);
+bool IsBinaryFormat(const char* format);
 
 extern istream& operator>> (istream& is, HexRecord& hx);
 
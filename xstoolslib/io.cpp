@@ -7,6 +7,8 @@
 #include <stdlib.h>
 #include <sys/io.h>
 #include <string.h>
+#include <map>
+#include <thread>
 
 #include "io.h"
 
@@ -36,30 +38,114 @@ const PinDef PinDefinitions[17] =
    {2, 0x08, 3, 1}  // Pin 17
 };
 
+// Number of IOPort objects holding permission for each I/O address on this thread.
+// ioperm() and iopl() only change the permissions of the calling thread, so each
+// thread that does port I/O needs its own grant.  Several port objects (one per
+// board component) share the same parallel port, so permission is only dropped
+// when the last holder on the thread releases it.
+static thread_local std::map<int, unsigned int> PermissionCount;
+
+// Number of addresses above IOPERM_LIMIT that are currently held through iopl() on this thread.
+static thread_local unsigned int IoplCount = 0;
+
 IOPort::IOPort(int Address, bool writable)
 {
     Addr = Address;
     CanWrite = writable;
+    Granted = false;
+}
+
+IOPort::~IOPort()
+{
+    Release();
+}
+
+// Gets permission for the calling thread to access the port register.  Returns true if
+// access is granted.  If the object was granted access on another thread, that grant is
+// given up and permission is acquired again for this thread.
+bool IOPort::Acquire()
+{
+    if (Granted && Holder != std::this_thread::get_id())
+    {
+        Release();
+    }
+    if (!Granted)
+    {
+        if (0 == PermissionCount[Addr])
+        {
+            int Result;
+
+            if (Addr + 1 <= IOPERM_LIMIT)
+            {
+                Result = ioperm(Addr, 1, 1);
+            }
+            else
+            {
+                Result = (0 == IoplCount) ? iopl(3) : 0;
+                if (0 == Result)
+                {
+                    IoplCount++;
+                }
+            }
+            if (0 != Result)
+            {
+                return false;
+            }
+        }
+        PermissionCount[Addr]++;
+        Granted = true;
+        Holder = std::this_thread::get_id();
+    }
+    return true;
+}
+
+// Gives up permission to access the port register.  The counts of another thread can't be
+// changed from here, so if the object is released on a different thread from the one that
+// acquired it, that thread keeps its permission until it exits.
+void IOPort::Release()
+{
+    if (Granted)
+    {
+        Granted = false;
+        if (Holder != std::this_thread::get_id())
+        {
+            return;
+        }
+        if (0 == --PermissionCount[Addr])
+        {
+            if (Addr + 1 <= IOPERM_LIMIT)
+            {
+                ioperm(Addr, 1, 0);
+            }
+            else if (0 == --IoplCount)
+            {
+                iopl(0);
+            }
+        }
+    }
+}
+
+// Returns true if the calling thread has permission to access the port register.
+bool IOPort::IsGranted() const
+{
+    return Granted && Holder == std::this_thread::get_id();
 }
 
 void IOPort::write(unsigned char Value)
 {
-    if (CanWrite)
+    if (CanWrite && (IsGranted() || Acquire()))
     {
-        ioperm(Addr, RegisterCount, 1);
         outb(Value, Addr);
-        ioperm(Addr, RegisterCount, 0);
     }
 }
 
 unsigned char IOPort::readChar()
 {
-    unsigned char Value;
-
-    ioperm(Addr, RegisterCount, 1);
-    Value = inb(Addr);
-    ioperm(Addr, RegisterCount, 0);
-    return Value;
+    if (IsGranted() || Acquire())
+    {
+        return inb(Addr);
+    }
+    return 0xFF;
 }
 
 
@@ -6,6 +6,8 @@
 #ifndef IO_H
 #define IO_H
 
+#include <thread>
+
 // Parallel Port registers
 #define RegisterCount 3
 
@@ -23,16 +25,31 @@ typedef struct
 } PinDef;
 
 
+// Highest I/O address + 1 that can be granted with ioperm(); ports above this need iopl().
+#define IOPERM_LIMIT 0x400
+
+// Port register access.  Permission to access the register is acquired once with
+// Acquire() and held until Release() (or the destructor) so that each read or write
+// is a bare inb()/outb() instead of a pair of ioperm() system calls around it.
+// Permission belongs to the thread that acquired it, so an object that is first used
+// on another thread acquires it again for that thread.
 class IOPort
 {
 private:
     int Addr;
     bool CanWrite;
+    bool Granted;             // true while this object holds access permission for Addr
+    std::thread::id Holder;   // thread that was granted the permission
 
 public:
     IOPort(int Address, bool writable);
+    ~IOPort();
 
 public:
+    bool Acquire();
+    void Release();
+    bool IsGranted() const;
+
     void write(unsigned char Value);
     unsigned char readChar();
 };
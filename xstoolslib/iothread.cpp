@@ -0,0 +1,138 @@
+#include "iothread.h"
+#include "parameters.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstdlib>
+
+/// Create the I/O thread and start it waiting for jobs.
+IOThread::IOThread(QObject *parent) :
+    QThread(parent)
+{
+    nextId = 0;
+    running = false;
+    stopping = false;
+    cancelled = false;
+
+    start(QThread::TimeCriticalPriority);
+}
+
+/// Drop any queued jobs, wait for the running job to end and stop the thread.
+IOThread::~IOThread(void)
+{
+    Cancel();
+
+    lock.lock();
+    stopping = true;
+    wake.wakeAll();
+    lock.unlock();
+
+    wait();
+}
+
+/// Queue a job to run after the jobs that were submitted before it.
+///\return the id that is passed back by the JobFinished() signal.
+int IOThread::Submit(IOJob job)	///< operation to perform on the I/O thread
+{
+    QMutexLocker locker(&lock);
+
+    int id = nextId++;
+    jobs.push_back(std::make_pair(id, job));
+    wake.wakeAll();
+    return id;
+}
+
+/// Run a job on the I/O thread and wait for it to finish.
+/// This is meant for short operations like setting up a board. The caller is blocked,
+/// so nothing can cancel the job before it runs.
+///\return the status returned by the job.
+bool IOThread::Run(IOJob job)	///< operation to perform on the I/O thread
+{
+    std::promise<bool> done;
+    std::future<bool> result = done.get_future();
+
+    Submit([&done, job](const std::atomic<bool>& cancelled)
+    {
+        bool status = job(cancelled);
+        done.set_value(status);
+        return status;
+    });
+    return result.get();
+}
+
+/// Tell the running job to stop and drop the jobs that haven't started.
+void IOThread::Cancel(void)
+{
+    QMutexLocker locker(&lock);
+
+    jobs.clear();
+    cancelled = true;
+}
+
+///\return true if a job is running or waiting to run.
+bool IOThread::IsBusy(void)
+{
+    QMutexLocker locker(&lock);
+
+    return running || !jobs.empty();
+}
+
+/// Apply the real-time policy and CPU pinning requested in the XSTOOLS parameters.
+void IOThread::SetupScheduling(void)
+{
+    if (Parameters::GetXSTOOLSParameter("IOTHREADFIFO") == "YES")
+    {
+        struct sched_param param;
+        param.sched_priority = (sched_get_priority_min(SCHED_FIFO) + sched_get_priority_max(SCHED_FIFO)) / 2;
+        if (0 != pthread_setschedparam(pthread_self(), SCHED_FIFO, &param))
+        {
+            qDebug() << "IOThread: SCHED_FIFO not allowed, using normal scheduling";
+        }
+    }
+
+#ifdef __linux__
+    string cpu = Parameters::GetXSTOOLSParameter("IOTHREADCPU");
+    if ("" != cpu)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(atoi(cpu.c_str()), &cpus);
+        if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus))
+        {
+            qDebug() << "IOThread: could not pin thread to CPU" << cpu.c_str();
+        }
+    }
+#endif
+}
+
+/// Run the queued jobs one at a time until the thread is stopped.
+void IOThread::run()
+{
+    SetupScheduling();
+
+    QMutexLocker locker(&lock);
+    while (!stopping)
+    {
+        if (jobs.empty())
+        {
+            wake.wait(&lock);
+            continue;
+        }
+
+        std::pair<int,IOJob> job = jobs.front();
+        jobs.pop_front();
+        running = true;
+        cancelled = false;	// any earlier Cancel() already emptied the queue, so it wasn't meant for this job
+
+        locker.unlock();
+        bool status = job.second(cancelled);
+        emit JobFinished(job.first, status);
+        locker.relock();
+
+        running = false;
+        if (jobs.empty())
+        {
+            emit AllJobsFinished();
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef IOTHREAD_H
+#define IOTHREAD_H
+
+#include <QtWidgets>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+
+/**
+Run board operations on a dedicated I/O thread.
+
+Jobs are queued and run one after another on a single thread, so the
+port bit-banging is never interrupted by GUI repaints and the GUI never
+has to pump its event loop from inside a transfer. The thread runs at
+the highest Qt priority. If the XSPARAM.TXT parameter IOTHREADFIFO is
+YES, it is switched to the SCHED_FIFO real-time policy, and if
+IOTHREADCPU holds a CPU number, the thread is pinned to that CPU.
+
+A job receives a cancel flag that it should check between the steps
+of a long operation. Cancel() sets the flag and drops the jobs that
+haven't started yet. The JobFinished() and AllJobsFinished() signals
+are delivered to receivers on the GUI thread through queued
+connections.
+
+Permission to access the port registers belongs to the thread that
+asked for it, so the board objects must be created and set up by a
+job (Run() waits for such a job to finish) before other jobs use them.
+
+*/
+
+/// A board operation. It is passed the cancel flag and returns true if it succeeded.
+typedef std::function<bool(const std::atomic<bool>& cancelled)> IOJob;
+
+class IOThread : public QThread
+{
+    Q_OBJECT
+
+signals:
+    void JobFinished(int id, bool status);
+    void AllJobsFinished();
+
+public:
+    IOThread(QObject *parent = NULL);
+    ~IOThread(void);
+    int Submit(IOJob job);
+    bool Run(IOJob job);
+    void Cancel(void);
+    bool IsBusy(void);
+
+protected:
+    void run();
+
+private:
+    void SetupScheduling(void);
+
+private:
+    QMutex lock;                ///< guards all the members below except the cancel flag
+    QWaitCondition wake;        ///< signalled when a job is queued or the thread must stop
+    std::deque< std::pair<int,IOJob> > jobs;	///< jobs waiting to run, with their ids
+    int nextId;                 ///< id of the next job to be submitted
+    bool running;               ///< true while a job is running
+    bool stopping;              ///< true when the thread must exit
+    std::atomic<bool> cancelled;	///< set by Cancel() for the running job
+};
+
+#endif
@@ -25,6 +25,7 @@
 
 #include "utils.h"
 #include "hexrecrd.h"
+#include "heximage.h"
 #include "jramprt.h"
 
 
@@ -126,6 +127,26 @@ bool JTAGRAMPort::DownloadRAM(const char *hexfileName,	///< receive data to down
     if(strlen(hexfileName)==0)
 		return false;  // stop if no hex file was given
 	
+	string desc("RAM Download"), subdesc("Downloading "+StripPrefix(hexfileName));
+
+	if(HexImage::CanLoad(hexfileName))
+	{ // load the whole hex or binary file at once and download it an extent at a time
+		HexImage image;
+		if(!image.Load(hexfileName,err))
+			return false;
+		progressGauge = new Progress(NULL, &err);
+		if (NULL != progressGauge)
+		{
+			progressGauge->Setup(desc,subdesc,0,image.GetNumBytes());
+
+			status = DownloadRAM(image,bigEndianBytes,bigEndianBits);
+
+			delete progressGauge;
+			progressGauge = NULL;
+		}
+		return status;
+	}
+
     ifstream is(hexfileName, ios::binary);  // otherwise open hex file
 	if(!is || is.fail() || is.eof()!=0)
 	{ // error - couldn't open hex file
@@ -140,7 +161,6 @@ bool JTAGRAMPort::DownloadRAM(const char *hexfileName,	///< receive data to down
 	streampos streamEndPos = is.tellg();	// pointer position = position of end of file
 	is.seekg(0,ios::beg);	// return pointer to beginning of file
 
-	string desc("RAM Download"), subdesc("Downloading "+StripPrefix(hexfileName));
     progressGauge = new Progress(NULL, &err);
     if (NULL != progressGauge)
     {
@@ -169,23 +189,7 @@ bool JTAGRAMPort::DownloadRAM(istream& is,	///< receive data to download through
 	assert(progressGauge != NULL);	//	make sure progress indicator is initialized
 	progressGauge->Report(0);	// start progress indicator at zero
 
-	XCBSDR& bsdr = *bsdrPtr;
-	Bitstream& bsir = *bsirPtr;
-	Bitstream null(0);
-	InitTAP();  // reset the TAP state controller
-	// get to a state where the controller will accept an instruction
-	GoThruTAPSequence(RunTestIdle,SelectDRScan,SelectIRScan,CaptureIR,ShiftIR, -1);
-	// first load an EXTEST instruction into the BSIR
-	bsir.Clear();	// all-zeroes is the EXTEST opcode
-	SendRcvBitstream(bsir, null);  // after this, TAP state is Exit1-IR
-	// activate the EXTEST instruction and get ready to send data to the DR
-	GoThruTAPSequence(UpdateIR, SelectDRScan, CaptureDR, ShiftDR, -1);
-	
-	// enable the RAM
-	bsdr.Clear();
-	bsdr.SetRAMControls(0,1,1); // enable RAM, disable writing
-	SendRcvBitstream(bsdr,null);
-	GoThruTAPSequence(UpdateDR,SelectDRScan,CaptureDR,ShiftDR,-1);
+	StartRAMAccess();
 
 	// read hex records from file and place data in the RAM of the board
 	while(is.eof()==0)
@@ -218,16 +222,42 @@ bool JTAGRAMPort::DownloadRAM(istream& is,	///< receive data to download through
 	}
 	progressGauge->Report(is.tellg());	// should set gauge to 100%
 	
-	bsdr.SetRAMControls(1,1,1); // disable RAM
-	SendRcvBitstream(bsdr,null);
-	GoThruTAPSequence(UpdateDR,-1);
-	
-	InitTAP();  // reset the TAP state controller
+	EndRAMAccess();
 	
 	return err.IsError() ? false:true;
 }
 
 
+/// Download the XS Board RAM with the contents of a hex image.
+///\return true if operation was successul, false otherwise
+bool JTAGRAMPort::DownloadRAM(const HexImage& image,	///< data to be downloaded
+					bool bigEndianBytes,	///< if true, data is stored in RAM with most-significant byte at lower address
+					bool bigEndianBits)		///< if true, data is stored in RAM with most-significant bit in position 0
+{
+	XSError& err = GetErr();
+
+	assert(progressGauge != NULL);	//	make sure progress indicator is initialized
+	progressGauge->Report(0);	// start progress indicator at zero
+
+	StartRAMAccess();
+
+	// write each extent of the image into the RAM of the board
+	unsigned long bytesDone = 0;
+	for(unsigned int e=0; e<image.GetNumExtents() && !err.IsError(); e++)
+	{
+		const HexExtent& extent = image.GetExtent(e);
+		WriteRAMBytes(extent.address,&extent.data[0],extent.data.size(),bigEndianBytes,bigEndianBits);
+		bytesDone += extent.data.size();
+		progressGauge->Report(bytesDone);
+	}
+	progressGauge->Report(image.GetNumBytes());	// should set gauge to 100%
+
+	EndRAMAccess();
+
+	return err.IsError() ? false:true;
+}
+
+
 /// Upload the XS Board RAM to a file.
 ///\return true if operation was successul, false otherwise
 bool JTAGRAMPort::UploadRAM(const char *hexfileName,	///< dump uploaded data to this file.
@@ -245,7 +275,7 @@ bool JTAGRAMPort::UploadRAM(const char *hexfileName,	///< dump uploaded data to
     if(strlen(hexfileName)==0)
 		return false;  // stop if no hex file was given
 	
-    ofstream os(hexfileName);  // otherwise open hex file
+    ofstream os(hexfileName, IsBinaryFormat(format) ? ios::out|ios::binary : ios::out);  // otherwise open hex file
 	if(os.fail() || os.eof()!=0)
 	{ // error - couldn't open hex file
 		err.SetSeverity(XSErrorMajor);
@@ -261,6 +291,11 @@ bool JTAGRAMPort::UploadRAM(const char *hexfileName,	///< dump uploaded data to
         progressGauge->Setup(desc,subdesc.append(StripPrefix(hexfileName)),loAddr,hiAddr);
 
         status = UploadRAM(os,format,loAddr,hiAddr,bigEndianBytes,bigEndianBits);
+        if (status)
+        {
+            // record where raw data came from so it can be downloaded again
+            status = HexImage::UpdateInfo(hexfileName, format, loAddr, hiAddr - loAddr + 1, err);
+        }
 	
         delete progressGauge;
         progressGauge = NULL;
@@ -340,19 +375,65 @@ bool JTAGRAMPort::DownloadHexRecordToRAM(HexRecord& hx,	///< hex record with dat
 					bool bigEndianBytes,	///< if true, data is stored in RAM with most-significant byte at lower address
 					bool bigEndianBits)		///< if true, data is stored in RAM with most-significant bit in position 0
 {
-	if(!hx.IsData()) // don't download unless this is RAM data
+	if(!hx.IsData() || hx.GetLength()==0) // don't download unless this is RAM data
 		return true;
 	
-	// process the bytes from a data-type hex record
-	for(unsigned int i=0; i<hx.GetLength(); i++)
+	WriteRAMBytes(hx.GetAddress(),&hx[0],hx.GetLength(),bigEndianBytes,bigEndianBits);
+	return true;
+}
+
+
+/// Load the EXTEST instruction and enable the RAM so its pins can be driven through the BSDR.
+void JTAGRAMPort::StartRAMAccess(void)
+{
+	XCBSDR& bsdr = *bsdrPtr;
+	Bitstream& bsir = *bsirPtr;
+	Bitstream null(0);
+	InitTAP();  // reset the TAP state controller
+	// get to a state where the controller will accept an instruction
+	GoThruTAPSequence(RunTestIdle,SelectDRScan,SelectIRScan,CaptureIR,ShiftIR, -1);
+	// first load an EXTEST instruction into the BSIR
+	bsir.Clear();	// all-zeroes is the EXTEST opcode
+	SendRcvBitstream(bsir, null);  // after this, TAP state is Exit1-IR
+	// activate the EXTEST instruction and get ready to send data to the DR
+	GoThruTAPSequence(UpdateIR, SelectDRScan, CaptureDR, ShiftDR, -1);
+	
+	// enable the RAM
+	bsdr.Clear();
+	bsdr.SetRAMControls(0,1,1); // enable RAM, disable writing
+	SendRcvBitstream(bsdr,null);
+	GoThruTAPSequence(UpdateDR,SelectDRScan,CaptureDR,ShiftDR,-1);
+}
+
+
+/// Disable the RAM and reset the TAP after StartRAMAccess().
+void JTAGRAMPort::EndRAMAccess(void)
+{
+	XCBSDR& bsdr = *bsdrPtr;
+	Bitstream null(0);
+	bsdr.SetRAMControls(1,1,1); // disable RAM
+	SendRcvBitstream(bsdr,null);
+	GoThruTAPSequence(UpdateDR,-1);
+	
+	InitTAP();  // reset the TAP state controller
+}
+
+
+/// Write consecutive bytes into the RAM once StartRAMAccess() has enabled it.
+void JTAGRAMPort::WriteRAMBytes(unsigned long address,	///< address of the first byte
+					const unsigned char* data,	///< bytes to be written
+					unsigned long length,	///< number of bytes
+					bool bigEndianBytes,	///< if true, data is stored in RAM with most-significant byte at lower address
+					bool bigEndianBits)		///< if true, data is stored in RAM with most-significant bit in position 0
+{
+	XCBSDR& bsdr = *bsdrPtr;
+	Bitstream null(0);
+	for(unsigned long i=0; i<length; i++)
 	{
-		XCBSDR& bsdr = *bsdrPtr;
-		Bitstream null(0);
-		
 		// load address and data onto the FPLD pins
 		bsdr.Clear();	// set all the BSDR bits to zero
-		bsdr.SetRAMAddress(hx.GetAddress()+i);
-		bsdr.SetRAMData(RearrangeData(hx[i],8,bigEndianBytes,bigEndianBits));
+		bsdr.SetRAMAddress(address+i);
+		bsdr.SetRAMData(RearrangeData(data[i],8,bigEndianBytes,bigEndianBits));
 		bsdr.SetRAMControls(0,1,1); // enable RAM, disable outputs, raise write line
 		SendRcvBitstream(bsdr,null);
 		GoThruTAPSequence(UpdateDR,SelectDRScan,CaptureDR,ShiftDR,-1);
@@ -365,7 +446,6 @@ bool JTAGRAMPort::DownloadHexRecordToRAM(HexRecord& hx,	///< hex record with dat
 		SendRcvBitstream(bsdr,null);
 		GoThruTAPSequence(UpdateDR,SelectDRScan,CaptureDR,ShiftDR,-1);
 	}
-	return true;
 }
 
 
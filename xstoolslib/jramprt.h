@@ -25,6 +25,7 @@
 #include "lptjtag.h"
 #include "xcbsdr.h"
 #include "hexrecrd.h"
+#include "heximage.h"
 
 
 #define BIG_ENDIAN_BYTES	true
@@ -69,6 +70,8 @@ class JTAGRAMPort : public LPTJTAG
 
 	bool DownloadRAM(istream& is, bool bigEndianBytes, bool bigEndianBits);
 
+	bool DownloadRAM(const HexImage& image, bool bigEndianBytes, bool bigEndianBits);
+
     bool UploadRAM(const char *hexfileName, const char* format, unsigned long loAddr,
 		unsigned long hiAddr, bool bigEndianBytes, bool bigEndianBits);
 
@@ -94,6 +97,13 @@ class JTAGRAMPort : public LPTJTAG
 	
 	private:
 
+	void StartRAMAccess(void);
+
+	void EndRAMAccess(void);
+
+	void WriteRAMBytes(unsigned long address, const unsigned char* data, unsigned long length,
+		bool bigEndianBytes, bool bigEndianBits);
+
 	Bitstream* bsirPtr;		///< storage for boundary-scan instruction register
 	XCBSDR* bsdrPtr;		///< storage for boundary-scan data register
 };
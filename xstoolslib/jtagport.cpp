@@ -29,7 +29,8 @@ using namespace std;
 
 #include "utils.h"
 #include "jtagport.h"
-#include "../xstoolslib/enum.h"
+#include "svfprog.h"
+#include "parameters.h"
 
 //#define DEBUG_SVF 1
 
@@ -63,44 +64,6 @@ static TAPState nextTAPState[16][2] =
 	{ RunTestIdle,        SelectDRScan   },     // UpdateIR
 };
 
-// This is a list of all JTAG SVF command words implemented in here.
-// For the name of each enum, use the exact text and case as per used in the SVF file.
-BETTER_ENUM(KeyWordSvf, char,  \
-    TRST = 1,               \
-    PIO,                    \
-    PIOMAP,                 \
-    FREQUENCY,              \
-    ENDIR,                  \
-    ENDDR,                  \
-    STATE,                  \
-    HIR,                    \
-    HDR,                    \
-    TIR,                    \
-    TDR,                    \
-    TDI,                    \
-    SIR,                    \
-    SDR,                    \
-    RUNTEST)
-
-// Use this function to map an SVF key word into a int code that can be used for switch() statement.
-// A return value of 0 means key word not recognised
-int GetSvfKeyCode(const char *SvfCmdWord)
-{
-    int Code;
-
-    Code = 0;
-    for (KeyWordSvf c : KeyWordSvf::_values())
-    {
-        if (0 == strcmp(c._to_string(), SvfCmdWord))
-        {
-            // Thats the command code to use.
-            Code = c;
-            break;
-        }
-    }
-    return Code;
-}
-
 // The following array stores the TAP state path to get from the
 // first state to the final state.  The first state is entered as the first index
 // to this array, the final state is entered as the second index to the array,
@@ -693,6 +656,7 @@ bool JTAGPort::Setup(XSError *e,	///< error reporting channel
 			ostream& traceOstream)	///< send trace messages to this output stream
 {
 	currentTAPState = InvalidTAPState;
+	tckVal = tmsVal = tdiVal = tdoVal = 0;
 	SetErr(e);
 	SetTraceOnOff(traceOnFlag,traceOstream);
 	if(progressGauge != NULL)
@@ -812,7 +776,7 @@ void JTAGPort::SetTraceOnOff(bool f,		///< if true, output trace of JTAG operati
 void JTAGPort::UpdateTAPState(unsigned int numTCKPulses) ///< number of clock pulses
 {
 	assert(currentTAPState>=TestLogicReset && currentTAPState<=UpdateIR);
-	unsigned int tms = GetTMS();
+	unsigned int tms = tmsVal & 1;	// use the last level sent to TMS instead of reading it back from the port
 	for(unsigned int i=numTCKPulses; i>0; i--)
 		currentTAPState = nextTAPState[currentTAPState][tms];
 }
@@ -852,6 +816,18 @@ void JTAGPort::GotoTAPState(TAPState finalState)	///< move to this state (which
 }
 
 
+/// Get the number of TCK pulses needed to move between two TAP states.
+///\return the number of TCK pulses GotoTAPState() would use.
+unsigned int JTAGPort::GetTAPPathLength(TAPState startState,	///< current TAP state
+								TAPState finalState)		///< TAP state to move to
+{
+	unsigned int n;
+	for(n=0; n<17 && TAPPath[startState][finalState][n]>=0; n++)
+		;
+	return n;
+}
+
+
 /// Check table of TAP state paths to make sure there are no invalid transitions.
 ///\return true if the table of state paths is valid, false if invalid.
 bool JTAGPort::TAPPathsOK(void)
@@ -1037,126 +1013,6 @@ int JTAGPort::GetIDCODEs(Bitstream ***idcodes) ///< pointer to array of ID code
 }
 
 
-// Read and entire SVF file into memory.
-static char *LoadFile(istream& is)
-{
-	long loadfile_start = clock();
-
-	// determine the size of the file
-	is.seekg(0,ios::end);		// move pointer to end of file
-	int length = is.tellg();	// pointer position = position of end of file
-	is.seekg(0,ios::beg);		// return pointer to beginning of file
-
-	char *buffer = new char[length+1];
-    if (NULL == buffer)
-	{
-		XSError err(cerr);
-		err.SimpleMsg(XSErrorFatal,"Unable to allocate enough memory to hold file.");
-	}
-    else
-    {
-        for(int i = 0; i <= length; i++)
-        {
-            buffer[i] = 0;
-        }
-        is.read(buffer, length);
-
-        long loadfile_finish = clock();
-        DEBUG_STMT("Time to load SVF file = " << (loadfile_finish-loadfile_start)/(CLOCKS_PER_SEC))
-    }
-
-	return buffer;
-}
-
-
-// Fetch the next line from the SVF file stored in memory
-static char* GetLineFromBuffer(char** buffer) // buffer holding SVF file
-{
-	char* beginBuffer = *buffer;
-	char* newBuffer = *buffer;
-	if(*newBuffer==0)
-		return NULL;
-	for(char b=*newBuffer; *newBuffer!=0x0a && *newBuffer!=0x0c && *newBuffer!=0; newBuffer++)
-		;
-	for( ; *newBuffer==0x0c || *newBuffer==0x0a; newBuffer++)
-		*newBuffer = 0;
-	*buffer = newBuffer;
-	return beginBuffer;
-}
-
-
-// Fetch the next SVF command from the SVF file stored in memory
-static char* GetSVFCmdFromBuffer(char** buffer)
-{
-	char* beginBuffer = *buffer;
-	char* newBuffer = *buffer;
-	if(*newBuffer==0)
-		return NULL;
-	while(*newBuffer!=0)
-	{
-		switch(*newBuffer)
-		{
-		case 0x0a:
-		case 0x0c:
-			*newBuffer++ = ' ';
-			break;
-		case '/':
-			if(*(newBuffer+1) != '/')
-			{
-				newBuffer++;
-				break;
-			}
-			*newBuffer++ = ' ';
-		case '!':
-			for( ; (*newBuffer!=0x0a) && (*newBuffer!=0x0c) && (*newBuffer!=0); newBuffer++)
-				*newBuffer = ' ';
-			break;
-		case ';':
-			*newBuffer = 0;
-			*buffer = newBuffer+1;
-			return beginBuffer;
-		default:
-			newBuffer++;
-			break;
-		}
-	}
-	*buffer = newBuffer;
-	return beginBuffer;
-}
-
-
-// Fetch the next word from an SVF command string
-static string NextWord(string& s)
-{
-	int pos = s.find_first_not_of(" \t\n\r");	// find beginning of word
-	if(pos==string::npos)
-	{	// no non-whitespace chars found, so string has no words
-		s = "";
-		return "";
-	}
-	s = s.substr(pos,s.length()-pos);	// remove leading whitespace
-	if(*(s.c_str()) == '(')
-	{
-		pos = s.find_first_of(")");			// find end of parenthesized hex
-		pos++;
-	}
-	else
-		pos = s.find_first_of(" \t\n\r");	// find end of first keyword
-	string word;
-	if(pos==string::npos)
-	{	// no more whitespace, so entire string is the last word
-		word = s;
-		s = "";
-	}
-	else
-	{	// extract the word from the string
-		word = s.substr(0,pos);	// get first keyword from command
-		s = s.substr(pos,s.length()-pos);	// remove keyword from command
-	}
-	return word;
-}
-
-
 // Fetch the next word from an SVF command received through an input stream
 static string NextWord(istream& is)
 {
@@ -1237,528 +1093,278 @@ static void NextCmd(istream& is)
 	}
 }
 
-bool JTAGPort::SendSVF(char *svfStart, bool *Successful)
+// Report the download progress to the user no more than once per second.
+///\return true if the user has cancelled the download.
+bool JTAGPort::ReportSVFProgress(unsigned long position, unsigned int& currentSecond)
 {
-    bool UserCancelled;
-    TAPState endir=RunTestIdle, enddr=RunTestIdle;
-    char* svf;
-    unsigned long elapsedTime;
-    long start;
-    long finish;
-    unsigned int currentSecond;
+    bool UserCancelled = false;
 
-    start = clock();
-    elapsedTime = 0;
-    currentSecond = clock()/CLOCKS_PER_SEC;
+    if (!IsBufferOn() && (unsigned int)(clock()/CLOCKS_PER_SEC)!=currentSecond)
+    {
+        currentSecond = clock()/CLOCKS_PER_SEC;
+
+        if (NULL != progressGauge)
+        {
+            progressGauge->Report(position);  // position in SVF file indicates the current progress
+            UserCancelled = progressGauge->UserHasCancelled();
+        }
+    }
+    return UserCancelled;
+}
 
-    static Bitstream hdr(0), hir(0), tdr(0), tir(0), sdr(0), sir(0);
+// Perform one operation of a compiled SVF program.
+///\return true if the operation was performed, false if the TDO bits didn't match the expected bits.
+bool JTAGPort::RunSVFOp(SVFProgram& prog, unsigned int opIndex)
+{
+    static Bitstream null(0);	// zero-length bitstream
+    static Bitstream tdo(0);	// bits received from TDO (reused so it isn't reallocated for every command)
+    const SVFOp& op = prog.GetOp(opIndex);
 
-    *Successful = true;
-    UserCancelled = false;
-    svf = svfStart;
-    while (Successful && !UserCancelled)
+    switch (op.code)
     {
-        // update progress to the user no more than once per second
-        if (!IsBufferOn() && (unsigned int)(clock()/CLOCKS_PER_SEC)!=currentSecond)
-        {
-            currentSecond = clock()/CLOCKS_PER_SEC;
+        case SVFOpState:
+            GotoTAPState((TAPState)op.state);
+            break;
 
-            if (NULL != progressGauge)
+        case SVFOpShiftIR:
+            // send bitstream into IR and go to the end state
+            GotoTAPState(ShiftIR);
+            SendRcvBitstream(prog.GetBitstream(op.arg),null);
+            GotoTAPState((TAPState)op.state);
+            break;
+
+        case SVFOpShiftDR:
+            // send bitstream into DR and go to the end state
+            GotoTAPState(ShiftDR);
+            SendRcvBitstream(prog.GetBitstream(op.arg),null);
+            GotoTAPState((TAPState)op.state);
+            break;
+
+        case SVFOpVerifyIR:
+        case SVFOpVerifyDR:
+            // send bitstream into IR or DR while capturing TDO, then check it against the expected bits
+            tdo.Resize(prog.GetBitstream(op.arg).GetLength());
+            GotoTAPState(op.code==SVFOpVerifyIR ? ShiftIR : ShiftDR);
+            SendRcvBitstream(prog.GetBitstream(op.arg),tdo);
+            GotoTAPState((TAPState)op.state);
+            if (!tdo.MaskedCompare(prog.GetBitstream(op.arg+1), prog.GetBitstream(op.arg+2)))
             {
-                progressGauge->Report(svf-svfStart);  // SVF string pointer position indicates the current progress
-                UserCancelled = progressGauge->UserHasCancelled();
+                XSError& err = GetErr();
+                err.SetSeverity(XSErrorMajor);
+                err << (op.code==SVFOpVerifyIR ? "SIR" : "SDR") << " TDO mismatch in SVF command ending at character " << (long)op.position << "\n";
+                err.EndMsg();
+                return false;
             }
+            break;
 
-//			progressGauge->Report(is.tellg());  // position in stream indicates the current progress
-        }
+        case SVFOpRunTest:
+            // insert delay while programming takes place
+            if (currentTAPState == TestLogicReset)
+            {
+                SetTMS(1); // TMS value to stay in RESET state
+            }
+            else
+            {
+                SetTMS(0); // TMS value to stay in IDLE, DRPAUSE or IRPAUSE state
+            }
+            PulseTCK(op.arg);
+            break;
+
+        default:
+            assert(1==0);
+            break;
+    }
+    return true;
+}
+
+// Compile the commands of an SVF file and perform each one as soon as it is compiled.
+// If the program is optimized, each command is optimized before it is performed so the
+// JTAG operations are the same as when the optimized program is played from the cache.
+///\return true if the user cancelled the download.
+bool JTAGPort::SendSVF(SVFReader& svf, SVFProgram& prog, bool keepProgram, bool optimize, bool *Successful)
+{
+    bool UserCancelled;
+    unsigned int currentSecond;
+
+    currentSecond = clock()/CLOCKS_PER_SEC;
+
+    *Successful = true;
+    UserCancelled = false;
+    while (*Successful && !UserCancelled)
+    {
+        UserCancelled = ReportSVFProgress(svf.GetPosition(), currentSecond);
 
         // collect one or more lines into a single SVF command
-        char *s = GetSVFCmdFromBuffer(&svf);
-        if (s == NULL)
+        if (!svf.NextCommand())
         {
             // All finished, sucessfully!
             break;
         }
 
-        string svfCmd = s;
-
-#ifdef DEBUG_SVF
-        if (svfCmd.length() < 1000)
+        unsigned int firstOp = prog.GetNumOps();
+        if (!prog.CompileCommand(svf, GetErr()))
         {
-            cout << "SVFCmd: --" << svfCmd << "--\n";
-            cout.flush();
+            InitTAP(); // reset TAP and idle the JTAG logic
+            *Successful = false;
+            break;
         }
-#endif
-
-        // remove the first keyword from the command
-        string keywd(NextWord(svfCmd));
-//		string keywd = NextWord(svfCmd);
-//		string keywd = NextWord(is);
-//		if(is.fail())
-//			break;	// exit if EOF
-        if(keywd == "")
-            continue;	// must be a blank line
-
-        int status;
-        unsigned long len;
-        int KeyCode ;
-
-        KeyCode = GetSvfKeyCode(keywd.c_str());
-
-#ifdef DEBUG_SVF
-        cout << "Keywd: --" << keywd <<  "-- Code:" << KeyCode << "\n"; cout.flush();
-#endif
-
-        switch (KeyCode)
+        if (optimize)
         {
-            case KeyWordSvf::_from_string("TRST"):
-            case KeyWordSvf::_from_string("PIO"):
-            case KeyWordSvf::_from_string("PIOMAP"):
-            case KeyWordSvf::_from_string("FREQUENCY"):
-                {
-#ifdef DEBUG_SVF
-                    cout << "-->Ignored\n"; cout.flush();
-#endif
-
-                    // these commands have nothing to do with configuration so ignore them
-//                  NextCmd(is);
-                    break;
-                }
-
-            case KeyWordSvf::_from_string("ENDIR"):
-                {
-                    string nw = NextWord(svfCmd);
-//              	string nw = NextWord(is);
-                    assert(nw != "");
-                    endir = LabelToTAPState(nw);
-#ifdef DEBUG_SVF
-                    cout << "-->" << GetTAPStateLabel(endir); cout.flush();
-#endif
-//      			NextCmd(is);
-                    break;
-                }
-
-            case KeyWordSvf::_from_string("ENDDR"):
-                {
-                    string nw = NextWord(svfCmd);
-//              	string nw = NextWord(is);
-                    assert(nw != "");
-                    enddr = LabelToTAPState(nw);
-#ifdef DEBUG_SVF
-                    cout << "-->" << GetTAPStateLabel(enddr); cout.flush();
-#endif
-//      			NextCmd(is);
-                    break;
-                }
-
-            case KeyWordSvf::_from_string("STATE"):
-                {
-                    string s;
-
-                    for(s = NextWord(svfCmd); s != ""; s = NextWord(svfCmd))
-//              	for(s=NextWord(is); s!=""; s=NextWord(is))
-                    {
-#ifdef DEBUG_SVF
-                        cout<< "--> " << s; cout.flush();
-#endif
-                        GotoTAPState(LabelToTAPState(s));
-                    }
-#ifdef DEBUG_SVF
-                    cout<< "\n"; cout.flush();
-#endif
-//      			NextCmd(is);
-                    break;
-                }
-
-            case KeyWordSvf::_from_string("HIR"):
-                {
-                    // initialize the header bits for loading into the IR
-                    // get the number of bits in the header
-                    status = sscanf(NextWord(svfCmd).c_str(),"%ld",&len);
-//            		status = sscanf(NextWord(is).c_str(),"%ld",&len);
-                    assert(status!=0);
-                    hir.Resize(len);
-                    if (len != 0)
-                    {
-                        // otherwise look for the TDI bitfield
-                        string word;
-
-                        for (word = NextWord(svfCmd); word != "TDI" && word != ""; word = NextWord(svfCmd))
-//        				for(word=NextWord(is); word!="TDI" && word!=""; word=NextWord(is))
-                            ;
-                        if (word == "TDI")
-                        {
-                            // replace the TDI bits only if the SVF command has a TDI bitfield
-                            word = NextWord(svfCmd); // get the TDI bits
-                            assert(word[0]=='(');
-                            assert(word[word.length()-1]==')');
-                            hir.FromHexString(len,word.c_str());
-//                			hir.FromHexStream(len,is,false);
-                        }
-                    }
-#ifdef DEBUG_SVF
-                    if(hir.GetLength() < 1000)
-                    {
-                        cout << "-->HIR val:" << hir << "\n"; cout.flush();
-                    }
-                    else
-                    {
-                        cout << "-->HIR val size[... " << hir.GetLength() << " ...]\n"; cout.flush();
-                    }
-#endif
-//                  NextCmd(is);
-                    break;
-                }
-
-            case KeyWordSvf::_from_string("HDR"):
-                {
-                    // initialize the header bits for loading into the DR
-                    // get the number of bits in the header
-                    status = sscanf(NextWord(svfCmd).c_str(),"%ld",&len);
-//                  status = sscanf(NextWord(is).c_str(),"%ld",&len);
-                    assert(status!=0);
-                    hdr.Resize(len);
-                    if (len != 0)
-                    {
-                        // otherwise look for the TDI bitfield
-                        string word;
-
-                        for (word = NextWord(svfCmd); word != "TDI" && word != ""; word = NextWord(svfCmd))
-//              		for(word=NextWord(is); word!="TDI" && word!=""; word=NextWord(is))
-                            ;
-                        if (word == "TDI")
-                        {
-                            // replace the TDI bits only if the SVF command has a TDI bitfield
-                            word = NextWord(svfCmd); // get the TDI bits
-                            assert(word[0]=='(');
-                            assert(word[word.length()-1]==')');
-                            hdr.FromHexString(len,word.c_str());
-//      					hdr.FromHexStream(len,is,false);
-                        }
-                    }
-#ifdef DEBUG_SVF
-                    if(hdr.GetLength()<1000)
-                    {
-                        cout << "--> HDRval:" << hdr << "\n"; cout.flush();
-                    }
-                    else
-                    {
-                        cout << "--> HDR val size[... " << hdr.GetLength() << " ...]\n"; cout.flush();
-                    }
-#endif
-//      			NextCmd(is);
-                    break;
-                }
-
-            case KeyWordSvf::_from_string("TIR"):
-                {
-                    // initialize the trailer bits for loading into the IR
-                    // get the number of bits in the trailer
-                    status = sscanf(NextWord(svfCmd).c_str(),"%ld",&len);
-//      			status = sscanf(NextWord(is).c_str(),"%ld",&len);
-                    assert(status!=0);
-                    tir.Resize(len);
-                    if (len != 0)
-                    {
-                        // otherwise look for the TDI bitfield
-                        string word;
-
-                        for (word = NextWord(svfCmd); word != "TDI" && word != ""; word = NextWord(svfCmd))
-//      				for(word=NextWord(is); word!="TDI" && word!=""; word=NextWord(is))
-                            ;
-                        if (word == "TDI")
-                        {
-                            // replace the TDI bits only if the SVF command has a TDI bitfield
-                            word = NextWord(svfCmd); // get the TDI bits
-                            assert(word[0]=='(');
-                            assert(word[word.length()-1]==')');
-                            tir.FromHexString(len,word.c_str());
-//                        	tir.FromHexStream(len,is,false);
-                        }
-                    }
-#ifdef DEBUG_SVF
-                    if(tir.GetLength()<1000)
-                    {
-                        cout << "--> TIRval:" << tir << "\n"; cout.flush();
-                    }
-                    else
-                    {
-                        cout << "--> TIRval size[... " << tir.GetLength() << " ...]\n"; cout.flush();
-                    }
-#endif
-//          		NextCmd(is);
-                    break;
-                }
-
-            case KeyWordSvf::_from_string("TDR"):
-                {
-                    // initialize the trailer bits for loading into the DR
-                    // get the number of bits in the trailer
-                    status = sscanf(NextWord(svfCmd).c_str(),"%ld",&len);
-//              	status = sscanf(NextWord(is).c_str(),"%ld",&len);
-                    assert(status!=0);
-                    tdr.Resize(len);
-                    if (len != 0)
-                    {
-                        // otherwise look for the TDI bitfield
-                        string word;
-
-                        for (word = NextWord(svfCmd); word != "TDI" && word != ""; word = NextWord(svfCmd))
-//              		for(word=NextWord(is); word!="TDI" && word!=""; word=NextWord(is))
-                            ;
-                        if (word == "TDI")
-                        {
-                            // replace the TDI bits only if the SVF command has a TDI bitfield
-                            word = NextWord(svfCmd); // get the TDI bits
-                            assert(word[0]=='(');
-                            assert(word[word.length()-1]==')');
-                            tdr.FromHexString(len,word.c_str());
-//                      	tdr.FromHexStream(len,is,false);
-                        }
-                    }
-#ifdef DEBUG_SVF
-                    if (tdr.GetLength()<1000)
-                    {
-                        cout << "--> TDRval:" << tdr << "\n"; cout.flush();
-                    }
-                    else
-                    {
-                        cout << "--> TDRval size[... " << tdr.GetLength() << " ...]\n"; cout.flush();
-                    }
-#endif
-//      			NextCmd(is);
-                    break;
-                }
+            prog.OptimizeOps(firstOp);
+        }
 
-            case KeyWordSvf::_from_string("SIR"):
-                {
-                    // send a bitstream into the instruction register
-                    // get the number of bits in the instruction register
-                    status = sscanf(NextWord(svfCmd).c_str(),"%ld",&len);
-//              	status = sscanf(NextWord(is).c_str(),"%ld",&len);
-                    assert(status!=0);
-                    assert(len>0);
-                    Bitstream bs(len); // load TDI bits into this bit stream
-                    string word;
-
-                    for (word = NextWord(svfCmd); word != "TDI" && word != ""; word = NextWord(svfCmd))
-//      			for(word=NextWord(is); word!="TDI" && word!=""; word=NextWord(is))
-                        ;
-                    if (word == "TDI")
-                    {
-                        word = NextWord(svfCmd); // get the TDI bits
-                        assert(word[0]=='(');
-                        assert(word[word.length()-1]==')');
-                        sir.FromHexString(len,word.c_str());
- //     				sir.FromHexStream(len,is,false);
-                    }
-
-                    // concatenate header, instruction, and trailer bitstreams
-                    bs = hir + sir + tir;
-
-#ifdef DEBUG_SVF
-                    if (bs.GetLength() < 1000)
-                    {
-                        cout << "--> SIRval len: " << len << " val(" << bs.ToHexString() << ")" << endl; cout.flush();
-                    }
-                    else
-                    {
-                        cout << "--> SIRval len: " << len << " size(... " << bs.GetLength() << " ...)" << endl; cout.flush();
-                    }
-#endif
-                    // send bitstream into IR and return to idle state
-                    GotoTAPState(ShiftIR);
-                    Bitstream null(0);	// zero-length bitstream
-                    SendRcvBitstream(bs,null);
-                    GotoTAPState(endir);
-//      			NextCmd(is);
-                    break;
-                }
+        for (unsigned int i = firstOp; *Successful && i < prog.GetNumOps(); i++)
+        {
+            *Successful = RunSVFOp(prog, i);
+        }
+        if (!*Successful)
+        {
+            InitTAP(); // stop at the first mismatch
+            break;
+        }
 
-            case KeyWordSvf::_from_string("SDR"):
-                {
-                    // send a bitstream into the data register
-                    // get the number of bits in the data register
-                    status = sscanf(NextWord(svfCmd).c_str(),"%ld",&len);
-//              	status = sscanf(NextWord(is).c_str(),"%ld",&len);
-                    assert(status!=0);
-                    assert(len>0);
-                    Bitstream bs(0); // load TDI bits into this bit stream
-                    string word;
-
-                    for (word = NextWord(svfCmd); word != "TDI" && word != ""; word = NextWord(svfCmd))
-//      			for(word=NextWord(is); word!="TDI" && word!=""; word=NextWord(is))
-                        ;
-                    if (word == "TDI")
-                    {
-                        word = NextWord(svfCmd); // get the TDI bits
-                        assert(word[0]=='(');
-                        assert(word[word.length()-1]==')');
-
-                        sdr.FromHexString(len,word.c_str());
-#ifdef DEBUG_SVF
-                        cout << "--> ASCII is #" << word.c_str() << "#" << endl; cout.flush();
-                        cout << "--> SDR TDI val len " << len << " val(" << sdr.ToHexString() << ")" << endl; cout.flush();
-#endif
-//              		sdr.FromHexStream(len,is,false);
-                    }
-
-                    // concatenate header, data, and trailer bitstreams
-                    bs = hdr + sdr + tdr;
-
-#ifdef DEBUG_SVF
-                    if (bs.GetLength() < 1000)
-                    {
-                        cout << "--> SDR len " << len << "val(" << bs.ToHexString() << ")" << endl; cout.flush();
-                    }
-                    else
-                    {
-                        cout << "--> SDR len " << len << " size(... " << bs.GetLength() << " ...)" << endl; cout.flush();
-                    }
-#endif
-                    // send bitstream into DR and return to Run-Test-Idle state
-                    long sdr_start = clock();
-                    GotoTAPState(ShiftDR);
-                    Bitstream null(0);	// zero-length bitstream
-                    SendRcvBitstream(bs,null);
-                    GotoTAPState(enddr);
-                    long sdr_finish = clock();
-                    DEBUG_STMT("SDR download elapsed time = " << (sdr_finish-sdr_start)/(CLOCKS_PER_SEC))
-//      			NextCmd(is);
-                    break;
-                }
+        if (!keepProgram)
+        {
+            prog.Reuse();	// nothing will be replayed, so build the next command in the same storage
+        }
+    }
+    prog.SetSourceLength(svf.GetPosition());
 
-            case KeyWordSvf::_from_string("RUNTEST"):
-                {
-                    // insert delay while programming takes place
-                    // get the number of microseconds to pause while programming the CPLD
-                    status = sscanf(NextWord(svfCmd).c_str(),"%ld",&len);
-//              	status = sscanf(NextWord(is).c_str(),"%ld",&len);
-                    assert(status!=0);
-                    elapsedTime += len;
-                    assert(NextWord(svfCmd) == "TCK");
-//              	assert(NextWord(is) == "TCK");
-#ifdef DEBUG_SVF
-                    cout << "--> RUNTEST " << endl; cout.flush();
-#endif
+    return UserCancelled;
+}
 
-                    if (currentTAPState == TestLogicReset)
-                    {
-                        SetTMS(1); // TMS value to stay in RESET state
-                    }
-                    else
-                    {
-                        SetTMS(0); // TMS value to stay in IDLE, DRPAUSE or IRPAUSE state
-                    }
-                    PulseTCK(len);
-                    DEBUG_STMT("delay = " << len << " us")
-//              	NextCmd(is);
-                    break;
-                }
+// Perform all the operations of a compiled SVF program.
+///\return true if the user cancelled the download.
+bool JTAGPort::PlaySVF(SVFProgram& prog, bool *Successful)
+{
+    bool UserCancelled;
+    unsigned int currentSecond;
 
-            case 0:
-                    // Unrecognised key word
+    currentSecond = clock()/CLOCKS_PER_SEC;
 
-            default:
-                {
-#ifdef DEBUG_SVF
-                    cout << "--> unknown SVF command: " << keywd << (string)"\n"; cout.flush();
-#endif
-                    // if we get here, then it's some strange junk we don't understand
-                    XSError err = GetErr();
-                    err.SetSeverity(XSErrorMajor);
-                    err << (string)"unknown SVF command: " << keywd << (string)"\n";
-                    err.EndMsg();
-                    InitTAP(); // reset TAP and idle the JTAG logic
-
-                    *Successful = false;
-                    break;
-                };
-        }
+    *Successful = true;
+    UserCancelled = false;
+    for (unsigned int i = 0; i < prog.GetNumOps() && *Successful && !UserCancelled; i++)
+    {
+        UserCancelled = ReportSVFProgress(prog.GetOp(i).position, currentSecond);
+        *Successful = RunSVFOp(prog, i);
+    }
+    if (!*Successful)
+    {
+        InitTAP(); // stop at the first mismatch
     }
-
-    finish = clock();
-    DEBUG_STMT("elapsed time = " << (finish-start)/(CLOCKS_PER_SEC))
-    DEBUG_STMT("elapsed time = " << elapsedTime << " us")
-
     return UserCancelled;
 }
 
 /// Process SVF file and send results to device attached to JTAG port.
+/// If the file name is known, the SVF commands are compiled into a program that is
+/// cached next to the file (unless the SVFCACHE parameter is NO). Later downloads of
+/// the same unchanged file play the cached program without parsing the SVF again.
+/// Cached programs have their redundant operations removed unless the SVFOPTIMIZE
+/// parameter is NO, and the same operations are removed as the SVF is compiled on the
+/// first download so every download sends the same JTAG sequence.
 ///< receive SVF through this input stream
-///< name of the file that was opened to create the input stream (used only for progress indicator)
+///< name of the file that was opened to create the input stream (used for progress indicator and cache)
 ///\return true if no errors were encountered, false otherwise.
 bool JTAGPort::DownloadSVF(istream& is,	const char *fileName, bool *UserCancelled)
 {
     bool Successful;
-    char *svfStart;
+    bool useCache;
+    bool optimize;
+    bool cached;
+    unsigned long long stamp;
+    string cacheFileName;
+    SVFProgram prog;
+    long start;
 
     Successful = false;
     *UserCancelled = false;
+    start = clock();
 
 	// determine the size of the SVF file
 	is.seekg(0,ios::end);	// move pointer to end of file
 	long svfLength = is.tellg();	// pointer position = position of end of file
 	is.seekg(0,ios::beg);	// return pointer to beginning of file
 
-    // is.tellg() stops working correctly after file is loaded into internal memory
-    svfStart = LoadFile(is);
-    if (NULL != svfStart)
+    // look for a program compiled from this SVF file by an earlier download
+    useCache = (NULL != fileName) && (0 != strlen(fileName)) && (Parameters::GetXSTOOLSParameter("SVFCACHE") != "NO");
+    cached = false;
+    stamp = useCache ? SVFProgram::Stamp(fileName) : 0;
+    useCache = useCache && (0 != stamp);
+    optimize = useCache && (Parameters::GetXSTOOLSParameter("SVFOPTIMIZE") != "NO");	// only programs that are kept get optimized
+    if (useCache)
     {
-        char *svf = svfStart;
+        cacheFileName = SVFProgram::CacheFileName(fileName);
+        cached = prog.Load(cacheFileName.c_str(), stamp, optimize);
+    }
+
+    // otherwise the SVF file is read a chunk at a time as the commands are executed
+    SVFReader svf(is);
 
-        // Progress is misleading if buffering is on, so somebody else has to report it, not us.
-        if (!IsBufferOn())
+    // Progress is misleading if buffering is on, so somebody else has to report it, not us.
+    if (!IsBufferOn())
+    {
+        // create a downloading progress gauge
+        if (NULL == progressGauge)
         {
-            // create a downloading progress gauge
-            if (NULL == progressGauge)
+            string desc("Download SVF"), subdesc("Downloading "+StripPrefix(fileName));
+            progressGauge = new Progress(NULL, &GetErr());
+            if (NULL != progressGauge)
             {
-                string desc("Download SVF"), subdesc("Downloading "+StripPrefix(fileName));
-                progressGauge = new Progress(NULL, &GetErr());
-                if (NULL != progressGauge)
-                {
-                    progressGauge->Setup(desc,subdesc,0,svfLength);
-                }
+                progressGauge->Setup(desc,subdesc,0,svfLength);
             }
         }
+    }
 
-        InitTAP();	// initialize the JTAG state machine
-        GoThruTAPSequence(RunTestIdle,-1); // home state for configuration
-	
-        if (NULL != progressGauge)
+    InitTAP();	// initialize the JTAG state machine
+    GoThruTAPSequence(RunTestIdle,-1); // home state for configuration
+
+    if (NULL != progressGauge)
+    {
+        progressGauge->Report(0); // start progress at 0 which is the beginning of the SVF file
+        *UserCancelled = progressGauge->UserHasCancelled();
+    }
+
+    if (!*UserCancelled)
+    {
+        if (cached)
         {
-            progressGauge->Report(svf-svfStart); // start progress at 0 which is the beginning of the SVF string
-            *UserCancelled = progressGauge->UserHasCancelled();
+            *UserCancelled = PlaySVF(prog, &Successful);
         }
-
-        if (!*UserCancelled)
+        else
         {
-            *UserCancelled = SendSVF(svfStart, &Successful);
+            *UserCancelled = SendSVF(svf, prog, useCache, optimize, &Successful);
 
-//            if (NULL != progressGauge)
-//            {
-//                progressGauge->Report(svf-svfStart); // should set gauge to 100%
-//                *UserCancelled = progressGauge->UserHasCancelled();
-//            }
+            // keep the program for next time (a read-only data directory just means no cache)
+            if (useCache && Successful && !*UserCancelled)
+            {
+                if (optimize)
+                {
+                    prog.Optimize();
+                    DEBUG_STMT("SVF optimizer saved " << prog.GetTCKsSaved() << " TCKs in " << fileName)
+                }
+                prog.Save(cacheFileName.c_str(), stamp);
+            }
         }
+    }
 
-        // done so reset TAP and idle the JTAG logic
-        InitTAP();
-        InsertDelay(CONFIG_SETTLE_TIME);
+    DEBUG_STMT("SVF " << (cached ? "cached" : "compiled") << " download elapsed time = " << (clock()-start)/(CLOCKS_PER_SEC))
 
-        if (progressGauge != NULL)
-        {
-            progressGauge = progressGauge->EndProgress();
-            delete progressGauge;
-            progressGauge = NULL;
-        }
+    // done so reset TAP and idle the JTAG logic
+    InitTAP();
+    InsertDelay(CONFIG_SETTLE_TIME);
 
-        delete[] svfStart;
+    if (progressGauge != NULL)
+    {
+        progressGauge = progressGauge->EndProgress();
+        delete progressGauge;
+        progressGauge = NULL;
     }
+
     return Successful;
 }
-	
-	
+
+
 /// Download the contents of an SVF file to a device attached to the JTAG port.
 ///\return true if no errors were encountered, false otherwise.
 bool JTAGPort::DownloadSVF(const char *fileName, bool *UserCancelled)	///< file containing SVF commands
@@ -1782,7 +1388,7 @@ bool JTAGPort::DownloadSVF(const char *fileName, bool *UserCancelled)	///< file
         else
         {
             status = DownloadSVF(is, fileName, UserCancelled);
-	
+
             is.close();  // close-up the SVF file}
         }
     }
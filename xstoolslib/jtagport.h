@@ -25,11 +25,15 @@
 #include "xserror.h"
 #include "bitstrm.h"
 #include "progress.h"
+#include "svfread.h"
 
 
 #define TRACEJTAG false
 
 
+class SVFProgram;
+
+
 /// Identifiers for all possible TAP states.
 typedef enum
 {
@@ -146,7 +150,7 @@ class JTAGPort
 
 	string GetTAPStateLabel(TAPState s);
 
-	TAPState LabelToTAPState(string label);
+	static TAPState LabelToTAPState(string label);
 
 	void UpdateTAPState(unsigned int numTCKPulses=1);
 
@@ -156,9 +160,11 @@ class JTAGPort
 
 	void GotoTAPState(TAPState finalState);
 
+	static unsigned int GetTAPPathLength(TAPState startState, TAPState finalState);
+
 	bool TAPPathsOK(void);
 
-	unsigned int SendRcvBit(unsigned int sendBit);
+	virtual unsigned int SendRcvBit(unsigned int sendBit);
 
 	/// Output a bitstream through TDI while receiving a bitstream through TDO.
 	virtual void SendRcvBitstream(Bitstream& sendBits, Bitstream& rcvBits, bool goToExit=true) = 0;
@@ -198,7 +204,10 @@ class JTAGPort
 	Progress	*progressGauge;	///< indicates progress of operations
 
 private:
-    bool SendSVF(char *svfStart, bool *Successful);
+    bool SendSVF(SVFReader& svf, SVFProgram& prog, bool keepProgram, bool optimize, bool *Successful);
+    bool PlaySVF(SVFProgram& prog, bool *Successful);
+    bool RunSVFOp(SVFProgram& prog, unsigned int opIndex);
+    bool ReportSVFProgress(unsigned long position, unsigned int& currentSecond);
     bool SendBitstream(istream& is, bool *Successful);
 };
 
@@ -69,6 +69,8 @@ bool LPTJTAG::Setup(XSError* e,	///< pointer to error reporting object
 	posTDI = pos_tdi;
 	posTDO = pos_tdo;
 	posPROG = pos_prog;
+	jtagPinMask = (1<<posTCK) | (1<<posTMS) | (1<<posTDI);
+	readsAvoided = 0;
 	JTAGPort::Setup(e);
     SetTraceOnOff(TRACEJTAG,cerr);	// don't trace TAP signals
     bool pportOK = PPort::Setup(e,portNum,invMask);
@@ -109,7 +111,7 @@ void LPTJTAG::PulseTCK(unsigned int numTCKPulses) ///< number of pulses to gener
 	if(numTCKPulses == 0)
 		return;
 	
-	assert(GetTCK()==0);  // quiescent state of TCK should be zero
+	assert(tckVal==0);  // quiescent state of TCK should be zero
 	
 	if(traceFlag)
 		*osTrace << GetTAPStateLabel(currentTAPState).c_str() << "\t"
@@ -121,17 +123,26 @@ void LPTJTAG::PulseTCK(unsigned int numTCKPulses) ///< number of pulses to gener
 		InsertDelay(numTCKPulses,MICROSECONDS);
 	else
 	{
-		GetTDO();  // get value on TDO before clock pulse (see SendRcvBit)
+		// TDO isn't sampled here since only SendRcvBit uses it, and it samples TDO itself
+		readsAvoided++;
 		UpdateTAPState(numTCKPulses);
 		for(unsigned int i=numTCKPulses; i>0; i--)
 		{
-			SetTCK(~GetTCK());  // toggle TCK output
-			SetTCK(~GetTCK());	// toggle it again
+			SetJTAGPins(1);	// raise TCK
+			SetJTAGPins(0);	// and lower it again
 		}
 	}
 }
 
 
+/// Output the current TMS and TDI levels along with the given TCK level in a single port update.
+void LPTJTAG::SetJTAGPins(unsigned int tck)	///< level for the TCK pin
+{
+	tckVal = tck & 1;
+	OutMasked(jtagPinMask, (tckVal<<posTCK) | ((tmsVal&1)<<posTMS) | ((tdiVal&1)<<posTDI));
+}
+
+
 /// Set the level on the JTAG TMS pin.
 void LPTJTAG::SetTMS(unsigned int b)
 {
@@ -192,7 +203,37 @@ int LPTJTAG::SetFlashEnable(unsigned int b)
 }
 
 
+/// Output a bit on TDI and pulse TCK while sampling TDO.
+/// This does the same thing as JTAGPort::SendRcvBit, but TDI, TMS and TCK are
+/// updated together so the pins only take one port write per clock edge.
+///\return the value on the TDO pin before the clock pulse.
+unsigned int LPTJTAG::SendRcvBit(unsigned int sendBit) ///< send this bit through TDI
+{
+	// Make sure we are in the Shift-IR or Shift-DR state.  Gathering
+	// and shifting out data isn't legal otherwise.
+	assert( currentTAPState==ShiftIR || currentTAPState==ShiftDR );
+	assert(tckVal==0);  // quiescent state of TCK should be zero
+
+	tdiVal = sendBit & 1;
+	SetJTAGPins(0);		// place the bit on TDI while TCK is low
+
+	if(traceFlag)
+		*osTrace << GetTAPStateLabel(currentTAPState).c_str() << "\t"
+        << "TMS:" << tmsVal << " "
+        << "TDI:" << tdiVal	<< " "
+        << "TDO:" << GetTDO() << endl;
+
+	GetTDO();	// get value on TDO before clock pulse
+	UpdateTAPState(1);
+	SetJTAGPins(1);		// TDI is clocked in on the rising edge of TCK
+	SetJTAGPins(0);
+
+	return tdoVal; // return the value on TDO pin before the clock pulse
+}
+
+
 #define MAX(a,b)	((a)<(b)?(b):(a))
+#define MIN(a,b)	((a)<(b)?(a):(b))
 /// Transmit a bitstream through TDI while receiving a bitstream through TDO.
 ///
 /// This subroutine assumes the TAP controller state is
@@ -220,30 +261,127 @@ void LPTJTAG::SendRcvBitstream(Bitstream& sendBits, ///< bits to send out TDI pi
 	// in the Shift-IR or Shift-DR state for the first length-1 cycles
 	SetTMS(0);
 
-	for( unsigned int i=0; i<length; i++ )
+	// Use the precomputed shift kernel unless tracing or the TCK, TMS and TDI pins are spread across registers.
+	if(!traceFlag && posTCK/8==posTMS/8 && posTCK/8==posTDI/8)
+	{
+		ShiftBitstream(sendBits,rcvBits,length,goToExit);
+	}
+	else
 	{
-		unsigned int rcvBit;
-		
-		// On the last bit, raise the TMS line so the TAP
-		// controller will move out of the Shift state into
-		// the Exit1 state.
-		if( i==length-1 && goToExit )
-			SetTMS(1);
-		
-		// send the next bit if the bitstream is not empty
-		if(sendBits.GetLength() > i)
-			rcvBit = SendRcvBit(sendBits[i]);
-		/* else just shift in a zero */
-		else
-			rcvBit = SendRcvBit(0);
-		
-		// store the received bit if the bitstream is not empty
-		if(rcvBits.GetLength() > i)
-			rcvBits.SetBit(i,rcvBit);
+		for( unsigned int i=0; i<length; i++ )
+		{
+			unsigned int rcvBit;
+			
+			// On the last bit, raise the TMS line so the TAP
+			// controller will move out of the Shift state into
+			// the Exit1 state.
+			if( i==length-1 && goToExit )
+				SetTMS(1);
+			
+			// send the next bit if the bitstream is not empty
+			if(sendBits.GetLength() > i)
+				rcvBit = SendRcvBit(sendBits[i]);
+			/* else just shift in a zero */
+			else
+				rcvBit = SendRcvBit(0);
+			
+			// store the received bit if the bitstream is not empty
+			if(rcvBits.GetLength() > i)
+				rcvBits.SetBit(i,rcvBit);
+		}
 	}
 
 	assert((currentTAPState==Exit1DR && goToExit) || (currentTAPState==Exit1IR && goToExit) ||
-		(currentTAPState==ShiftDR && !goToExit) || (currentTAPState==ShiftDR && !goToExit));
+		(currentTAPState==ShiftDR && !goToExit) || (currentTAPState==ShiftIR && !goToExit));
+}
+
+
+/// Shift a bitstream through TDI while receiving a bitstream through TDO using precomputed register values.
+///
+/// The register bytes for every combination of TCK, TMS and TDI are computed once and then each bit
+/// takes just two register writes and one read: TDI (and TCK falling from the previous bit) are output,
+/// TDO is sampled, and then TCK is raised.  The bitstreams are processed a word at a time.
+/// TDO is only read for bits that are stored in rcvBits, so sending with an empty rcvBits
+/// (as SVF files and bitstream downloads do) doesn't read the port at all.
+/// The TCK, TMS and TDI pins must all be in the same parallel port register.
+void LPTJTAG::ShiftBitstream(Bitstream& sendBits,	///< bits to send out TDI pin
+					Bitstream& rcvBits,		///< bits received through TDO pin
+					unsigned int length,	///< number of bits to shift
+					bool goToExit)			///< if true, raise TMS on the last bit to enter the exit state
+{
+	const unsigned short jtagReg = posTCK / 8;	// register holding TCK, TMS and TDI
+	const unsigned short tdoReg = posTDO / 8;	// register holding TDO
+	const unsigned int tdoShift = posTDO % 8;
+	const unsigned int tdoInv = (GetInvMask() >> posTDO) & 1;
+	const unsigned int bitsPerWord = Bitstream::GetBitsPerWord();
+
+	assert(tckVal==0);  // quiescent state of TCK should be zero
+
+	// register values indexed by [TMS][TDI][TCK]
+	unsigned char pattern[2][2][2];
+	for(unsigned int tms=0; tms<2; tms++)
+		for(unsigned int tdi=0; tdi<2; tdi++)
+			for(unsigned int tck=0; tck<2; tck++)
+				pattern[tms][tdi][tck] = PinPattern(jtagReg,jtagPinMask,(tck<<posTCK) | (tms<<posTMS) | (tdi<<posTDI));
+
+	const unsigned long* sendWords = sendBits.GetWords();
+	unsigned long* rcvWords = rcvBits.GetWords();
+	const unsigned int sendLength = sendBits.GetLength();
+	const unsigned int rcvLength = rcvBits.GetLength();
+
+	unsigned int tms = 0, tdi = 0, tdo = tdoVal;
+	for(unsigned int i=0, w=0; i<length; w++)
+	{
+		// get the next word of bits to send (and remember it before it's overwritten if sendBits and rcvBits are the same)
+		unsigned long sendWord = i<sendLength ? sendWords[w] : 0;
+		unsigned long rcvWord = 0;
+		unsigned int numBits = MIN(bitsPerWord,length-i);
+
+		for(unsigned int b=0; b<numBits; b++, i++)
+		{
+			// send zeroes after the end of sendBits, and raise TMS on the last bit to go to the Exit1 state
+			tdi = i<sendLength ? (sendWord>>b) & 1 : 0;
+			tms = (i==length-1 && goToExit) ? 1 : 0;
+			OutRaw(jtagReg,pattern[tms][tdi][0]);	// place bit on TDI and lower TCK from the previous bit
+			if(i<rcvLength)
+				tdo = ((InRaw(tdoReg)>>tdoShift) & 1) ^ tdoInv;	// get value on TDO before the clock pulse
+			else
+				readsAvoided++;
+			OutRaw(jtagReg,pattern[tms][tdi][1]);	// raise TCK to shift the bit
+			rcvWord |= (unsigned long)tdo << b;
+		}
+
+		// store the received bits without disturbing any bits past the end of rcvBits
+		if(i-numBits < rcvLength)
+		{
+			unsigned int numRcvBits = MIN(numBits,rcvLength-(i-numBits));
+			unsigned long rcvMask = numRcvBits<bitsPerWord ? (1UL<<numRcvBits)-1 : ~0UL;
+			rcvWords[w] = (rcvWords[w] & ~rcvMask) | (rcvWord & rcvMask);
+		}
+	}
+	OutRaw(jtagReg,pattern[tms][tdi][0]);	// finish with TCK low
+
+	tckVal = 0;
+	tmsVal = tms;
+	tdiVal = tdi;
+	tdoVal = tdo;
+	if(goToExit)
+		UpdateTAPState(1);	// the last bit moved the TAP controller into the Exit1 state
+}
+
+
+/// Get the number of port reads that were skipped because their values weren't needed.
+///\return the number of skipped reads.
+unsigned long LPTJTAG::GetNumReadsAvoided(void) const
+{
+	return readsAvoided;
+}
+
+
+/// Clear the count of skipped port reads.
+void LPTJTAG::ResetNumReadsAvoided(void)
+{
+	readsAvoided = 0;
 }
 
 
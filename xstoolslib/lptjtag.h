@@ -82,8 +82,14 @@ class LPTJTAG : public JTAGPort, public PPort
 
 	int SetFlashEnable(unsigned int b);
 
+	unsigned int SendRcvBit(unsigned int sendBit);
+
 	void SendRcvBitstream(Bitstream& sendBits, Bitstream& rcvBits, bool goToExit=true);
 
+	unsigned long GetNumReadsAvoided(void) const;
+
+	void ResetNumReadsAvoided(void);
+
 	unsigned char ApplyTestVectors(unsigned char singleVector, unsigned char mask,
 		unsigned char *vector=NULL, unsigned char *response=NULL, unsigned int numVectors=1);
 
@@ -94,11 +100,17 @@ class LPTJTAG : public JTAGPort, public PPort
 
 	private:
 
+	void SetJTAGPins(unsigned int tck);
+
+	void ShiftBitstream(Bitstream& sendBits, Bitstream& rcvBits, unsigned int length, bool goToExit);
+
 	unsigned int posTCK;	///< position of JTAG clock pin
 	unsigned int posTMS;	///< position of JTAG mode pin
 	unsigned int posTDI;	///< position of JTAG data input pin
 	unsigned int posTDO;	///< position of JTAG data output pin
 	unsigned int posPROG;	///< position of FPGA PROG# pin
+	unsigned int jtagPinMask;	///< selects the TCK, TMS and TDI pins in the parallel port
+	unsigned long readsAvoided;	///< number of TDO reads skipped because nothing was being received
 };
 
 #endif
@@ -24,6 +24,8 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <time.h>
+#include <map>
 
 using namespace std;
 
@@ -53,12 +55,23 @@ static const unsigned int maxPortNum = 4;		// maximum parallel port #
 // Some macros for handling bit fields
 #define LOWFIELDMASK(lo,hi)	((1<<((hi)-(lo)+1))-1)
 #define FIELDMASK(lo,hi)	(LOWFIELDMASK(lo,hi)<<(lo))
+#define REGMASK(r)			(0xFFU<<(8*(r)))	// bits of the 24-bit field held in register r
 
 static const unsigned int minBitPos = 0;	// minimum index into parallel port register bits
 static const unsigned int maxBitPos = 23;	// maximum index into parallel port register bits
 
 static const unsigned int enableJTAGPinPos = 5;	// index of pin that enables/disables JTAG (pin D6)
 
+static const unsigned int numThroughputOps = 10000;	// number of register reads used to measure port throughput
+
+
+// Get the register accesses per second measured for each parallel port the first time it was opened.
+static map<unsigned int,double>& PortThroughputs(void)
+{
+	static map<unsigned int,double> throughputs;	// accesses per second, by port number or I/O address
+	return throughputs;
+}
+
 
 // Get the value stored in a bit field.
 static unsigned int GetField(unsigned int data,		// port data
@@ -90,6 +103,7 @@ PPort::PPort(void)
     : Transport()
 {
 	dataPort = statusPort = controlPort = NULL;
+	shadow = &SharedShadow(0);		// not attached to a port, yet
 }
 
 
@@ -101,6 +115,7 @@ PPort::PPort(XSError* e,				///< error reporting channel
     : Transport()
 {
 	dataPort = statusPort = controlPort = NULL;
+	shadow = &SharedShadow(0);		// not attached to a port, yet
 	Setup(e,n,invMask);
 }
 
@@ -108,9 +123,7 @@ PPort::PPort(XSError* e,				///< error reporting channel
 /// Destructor for parallel port object.
 PPort::~PPort(void)
 {
-	if(dataPort != NULL) delete dataPort;
-	if(statusPort != NULL) delete statusPort;
-	if(controlPort != NULL) delete controlPort;
+	ReleasePorts();
 }
 
 
@@ -136,7 +149,12 @@ bool PPort::Setup(XSError* e,			///< error reporting channel
 	else
 		chkCounter = 100;			// number of times to initially check port for correct operation
 
+	// see if the port registers should be kept in software and only written when they change
+	sprintf(s,"LPT%1dSHADOW",n);
+	shadowRegs = Parameters::GetXSTOOLSParameter(s) != "NO";
+
 	updateCounter = 0;
+	ResetIOCounts();
 
 	enableJTAG = false;				// disable JTAG operations in the parallel port interface by default
 	enableJTAGPinSet = false;		// the pin that enables/disables JTAG ops has not been set, yet
@@ -173,10 +191,14 @@ PPort& PPort::operator=(PPort& src)
 	invMask			= src.invMask;
 	chkCounter		= src.chkCounter;
 	IODriverIndex	= src.IODriverIndex;
-	regvals			= src.regvals;
+	shadow			= src.shadow;
 	updateCounter	= src.updateCounter;
 	enableJTAG      = src.enableJTAG;
 	enableJTAGPinSet = src.enableJTAGPinSet;
+	shadowRegs		= src.shadowRegs;
+	writesIssued	= src.writesIssued;
+	writesSuppressed = src.writesSuppressed;
+	readsIssued		= src.readsIssued;
 
 	return *this;
 }
@@ -228,20 +250,92 @@ bool PPort::SetLPTNum(unsigned int n)	///< parallel port number or I/O address
 	case UNIIO:
 	default:
 		{
+            ReleasePorts();		// give up any port this object was previously assigned to
             if (0 != address)
             {
                 dataPort = new IOPort(address,true);		// writeable data port
                 statusPort = new IOPort(address+1,false);	// readable status port
                 controlPort = new IOPort(address+2,true);	// writeable control
+
+                // get access to the port registers once here instead of on every read or write
+                if (!dataPort->Acquire() || !statusPort->Acquire() || !controlPort->Acquire())
+                {
+                    DEBUG_STMT("No permission to access parallel port at 0x" << hex << address)
+                    ReleasePorts();
+                    address = 0;
+                }
+                else if (0 == PortThroughputs().count(n))
+                {
+                    PortThroughputs()[n] = MeasureThroughput();
+                }
             }
 			break;
 		}
 	}
 
+	// use the same register copies as every other object attached to this port
+	shadow = &SharedShadow(address);
+
     return (0 != address);		// return true if a parallel port was found
 }
 
 
+/// Get the software copies of the registers for the parallel port at a given I/O address.
+/// All the objects for a port share these copies so a write through one object is seen by the others.
+///\return the register copies for the port.
+PPort::RegShadow& PPort::SharedShadow(unsigned int address)	///< I/O address of the parallel port
+{
+	static map<unsigned int,RegShadow> shadows;	// register copies for each port address
+	map<unsigned int,RegShadow>::iterator i = shadows.find(address);
+	if(i == shadows.end())
+	{
+		RegShadow s;
+		s.regvals = 0;
+		s.valid = false;	// register copies are loaded from the hardware on the first access
+		i = shadows.insert(make_pair(address,s)).first;
+	}
+	return i->second;
+}
+
+
+/// Deletes the I/O port objects, which releases the permission to access the port registers.
+void PPort::ReleasePorts(void)
+{
+	if(dataPort != NULL) delete dataPort;
+	if(statusPort != NULL) delete statusPort;
+	if(controlPort != NULL) delete controlPort;
+	dataPort = statusPort = controlPort = NULL;
+}
+
+
+/// Measures the number of parallel port register accesses that can be done per second.
+///\return the number of accesses per second.
+double PPort::MeasureThroughput(void)
+{
+	struct timespec startTime, endTime;
+
+	// reading the status register has no effect on the pins, so it is safe to do this at any time
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for(unsigned int i=0; i<numThroughputOps; i++)
+		statusPort->readChar();
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+	double elapsed = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_nsec - startTime.tv_nsec) * 1.0e-9;
+	double throughput = (elapsed > 0.0) ? numThroughputOps / elapsed : 0.0;
+	DEBUG_STMT("Parallel port 0x" << hex << address << dec << ": " << (unsigned long)throughput << " ops/second")
+	return throughput;
+}
+
+
+/// Gets the register access rate measured when a parallel port was first opened.
+///\return the number of accesses per second, or 0 if the port hasn't been opened.
+double PPort::GetThroughput(unsigned int n)	///< parallel port number or I/O address given to SetLPTNum()
+{
+	map<unsigned int,double>::const_iterator i = PortThroughputs().find(n);
+	return (i != PortThroughputs().end()) ? i->second : 0.0;
+}
+
+
 /// Gets the parallel port number for a parallel port object.
 ///\return the parallel port number.
 unsigned int PPort::GetLPTNum(void) const
@@ -263,6 +357,8 @@ unsigned char PPort::Inp(unsigned short regOffset /**< offset into parallel port
 		Out(enableJTAG,enableJTAGPinPos,enableJTAGPinPos); // now set it
 	}
 
+	readsIssued++;
+
 	switch(IODriverIndex)
 	{
 	case DRIVERLINX:
@@ -308,6 +404,8 @@ void PPort::Outp(unsigned short regOffset,	///< offset into parallel port regist
 		Out(enableJTAG,enableJTAGPinPos,enableJTAGPinPos); // now set it
 	}
 
+	writesIssued++;
+
 	switch(IODriverIndex)
 	{
 	case DRIVERLINX:
@@ -346,64 +444,71 @@ void PPort::Out(unsigned int v,		///< value to output
 				unsigned int loPos,	///< low bit position of field
 				unsigned int hiPos)	///< high bit position of field
 {
-	unsigned int d, new_d;
 	assert(loPos<=23);
 	assert(hiPos<=23);
 	assert(loPos<=hiPos);
-	if((updateCounter & 0xF)==0 || chkCounter!=0)
+	OutMasked(FIELDMASK(loPos,hiPos),v<<loPos);
+}
+
+
+/// Output values on an arbitrary set of pins of the concatenated 24-bit parallel port field.
+/// Each register containing one of the selected pins is written once no matter how many of its pins change,
+/// so several pins (e.g. TCK, TMS and TDI) can be updated together.
+/// Bits  0 -  7:	data pins
+/// Bits 15 -  8:	status pins
+/// Bits 23 - 16:	control pins
+void PPort::OutMasked(unsigned int mask,	///< a 1 selects the pin at that position for output
+				unsigned int v)				///< values for the selected pins (other bits are ignored)
+{
+	unsigned int d, new_d;
+	assert((mask & ~FIELDMASK(minBitPos,maxBitPos)) == 0);
+
+	// Set the pin that enables/disables JTAG operations before taking a copy of the registers
+	// so the nested call to Out() can't change them underneath this one.
+	if(enableJTAGPinSet == false)
 	{
-		if(hiPos<8)
-			regvals = (regvals & ~0x0000FF) | Inp(0);
-		else if(loPos>15)
-			regvals = (regvals & ~0xFF0000) | (Inp(2)<<16);
-		else if(loPos>=8 && hiPos<=15)
-			regvals = (regvals & ~0x00FF00) | (Inp(1)<<8);
-		else
-			regvals = (Inp(2)<<16) | (Inp(1)<<8) | Inp(0);
+		enableJTAGPinSet = true;
+		Out(enableJTAG,enableJTAGPinPos,enableJTAGPinPos);
 	}
-	updateCounter++;
-	
-	d = regvals;
-	new_d = (d & ~FIELDMASK(loPos,hiPos)) | (((v<<loPos)^invMask) & FIELDMASK(loPos,hiPos));
-	regvals = new_d;
 
-	if(hiPos<8)
-		Outp(0,new_d);
-	else if(loPos>15)
-		Outp(2,new_d>>16);
-	else if(loPos>=8 && hiPos<=15)
-		Outp(1,new_d>>8);
-	else
+	if(shadowRegs)
 	{
-		Outp(0,new_d);
-		Outp(1,new_d>>8);
-		Outp(2,new_d>>16);
+		// the register copies are authoritative, so only load them if they haven't been loaded yet
+		if(!shadow->valid)
+			Resync();
 	}
+	else if((updateCounter & 0xF)==0 || chkCounter!=0)
+	{
+		// reload the registers that are going to be changed
+		for(unsigned short r=0; r<3; r++)
+			if(mask & REGMASK(r))
+				shadow->regvals = (shadow->regvals & ~REGMASK(r)) | (Inp(r)<<(8*r));
+	}
+	updateCounter++;
+	
+	d = shadow->regvals;
+	new_d = (d & ~mask) | ((v^invMask) & mask);
+	shadow->regvals = new_d;
+
+	for(unsigned short r=0; r<3; r++)
+		if(mask & REGMASK(r))
+			OutReg(r,d,new_d);
 
 	if(chkCounter > 0)
 	{ // check the value output on the port to make sure it matches the value that was sent
 		// this check is only performed for the first few uses of the parallel port
 		chkCounter--;
-		if(hiPos<8)
-		{
-			d = Inp(0);
-			new_d &= 0xff;	// zero the unused part of new output data
-		}
-		else if(loPos>15)
+		unsigned int regsMask = 0;
+		d = 0;
+		for(unsigned short r=0; r<3; r++)
 		{
-			d = Inp(2)<<16;
-			new_d &= 0xff0000;	// zero the unused part of new output data
-		}
-		else if(loPos>=8 && hiPos<=15)
-		{
-			d = Inp(1)<<8;
-			new_d &= 0xff00;	// zero the unused part of new output data
-		}
-		else
-		{
-			d = Inp(0) | (Inp(1)<<8) | (Inp(2)<<16);
-			new_d &= 0xffffff;	// zero the unused part of new output data
+			if(mask & REGMASK(r))
+			{
+				d |= Inp(r)<<(8*r);
+				regsMask |= REGMASK(r);
+			}
 		}
+		new_d &= regsMask;	// zero the unused part of new output data
 		if(d != new_d)
 		{
             err->SimpleMsg(XSErrorMajor, "Parallel port not responding!!\n\nCHECK YOUR PARALLEL PORT HARDWARE ADDRESS!!\n");
@@ -412,6 +517,49 @@ void PPort::Out(unsigned int v,		///< value to output
 }
 
 
+/// Write a register from the concatenated 24-bit register value unless the shadow copy shows it is already there.
+void PPort::OutReg(unsigned short regOffset,	///< offset into parallel port register set
+				unsigned int oldRegs,			///< concatenated register values before the update
+				unsigned int newRegs)			///< concatenated register values after the update
+{
+	unsigned char oldByte = (oldRegs >> (8*regOffset)) & 0xFF;
+	unsigned char newByte = (newRegs >> (8*regOffset)) & 0xFF;
+
+	if(shadowRegs && shadow->valid && oldByte==newByte && chkCounter==0)
+		writesSuppressed++;		// the register already holds this value
+	else
+		Outp(regOffset,newByte);
+}
+
+
+/// Reload the software copies of the data, status and control registers from the hardware.
+/// This only needs to be called if something other than this object may have changed the registers.
+void PPort::Resync(void)
+{
+	shadow->valid = false;	// don't let the Out() done by Inp() for the JTAG enable pin use the stale copy
+	shadow->regvals = (Inp(2)<<16) | (Inp(1)<<8) | Inp(0);
+	shadow->valid = true;
+}
+
+
+/// Get the number of register writes and reads done and the number of writes skipped because the register didn't change.
+void PPort::GetIOCounts(unsigned long& writes,		///< number of register writes issued
+						unsigned long& suppressed,	///< number of register writes skipped
+						unsigned long& reads) const	///< number of register reads issued
+{
+	writes = writesIssued;
+	suppressed = writesSuppressed;
+	reads = readsIssued;
+}
+
+
+/// Clear the register access counters.
+void PPort::ResetIOCounts(void)
+{
+	writesIssued = writesSuppressed = readsIssued = 0;
+}
+
+
 /// Return the current values on the designated pins of the concatenated 24-bit parallel port field.
 /// Bits  0 -  7:	data pins
 /// Bits 15 -  8:	status pins
@@ -427,22 +575,22 @@ unsigned int PPort::In(unsigned int loPos,	///< low bit position of field
 	if(hiPos<8)
 	{
 		d = Inp(0);
-		regvals = (regvals & ~0x0000FF) | d;
+		shadow->regvals = (shadow->regvals & ~0x0000FF) | d;
 	}
 	else if(loPos>15)
 	{
 		d = Inp(2)<<16;
-		regvals = (regvals & ~0xFF0000) | d;
+		shadow->regvals = (shadow->regvals & ~0xFF0000) | d;
 	}
 	else if(loPos>=8 && hiPos<=15)
 	{
 		d = Inp(1)<<8;
-		regvals = (regvals & ~0x00FF00) | d;
+		shadow->regvals = (shadow->regvals & ~0x00FF00) | d;
 	}
 	else
 	{
 		d = Inp(0) | (Inp(1)<<8) | (Inp(2)<<16);
-		regvals = d;
+		shadow->regvals = d;
 	}
 	return ((d^invMask) & FIELDMASK(loPos,hiPos)) >> loPos;
 }
@@ -458,6 +606,46 @@ void PPort::SetInvMask(unsigned int mask)
 }
 
 
+/// Get the inversion mask for the concatenated 24-bit parallel port field.
+///\return the inversion mask.
+unsigned int PPort::GetInvMask(void) const
+{
+	return invMask;
+}
+
+
+/// Compute the byte that would be written to a register if the given pins were changed.
+/// This lets a caller precompute register values for a tight loop of OutRaw() calls.
+/// The result is only valid while none of the other pins in the register change.
+///\return the value to write to the register.
+unsigned char PPort::PinPattern(unsigned short regOffset,	///< offset into parallel port register set
+				unsigned int mask,		///< a 1 selects the pin at that position (must all lie in the register)
+				unsigned int v) const	///< values for the selected pins
+{
+	assert(regOffset < 3);
+	assert((mask & ~REGMASK(regOffset)) == 0);
+	return (((shadow->regvals & ~mask) | ((v^invMask) & mask)) >> (8*regOffset)) & 0xFF;
+}
+
+
+/// Write a byte directly to a register without any field masking, inversion or verification.
+/// The software copy of the register is kept up to date.
+void PPort::OutRaw(unsigned short regOffset,	///< offset into parallel port register set
+				unsigned char byte)				///< data to write to the register
+{
+	shadow->regvals = (shadow->regvals & ~REGMASK(regOffset)) | (byte << (8*regOffset));
+	Outp(regOffset,byte);
+}
+
+
+/// Read a byte directly from a register without any field masking or inversion.
+///\return the contents of the register.
+unsigned char PPort::InRaw(unsigned short regOffset)	///< offset into parallel port register set
+{
+	return Inp(regOffset);
+}
+
+
 /// Set/clear flag to enable or disable JTAG operations thru the parallel port.
 void PPort::EnableJTAG(bool value)
 {
@@ -538,6 +726,10 @@ int PPort::Open(unsigned int Param)
 
 int PPort::Close()
 {
+    // give up access to the port registers; they are reacquired if the port is used again
+    if(dataPort != NULL) dataPort->Release();
+    if(statusPort != NULL) statusPort->Release();
+    if(controlPort != NULL) controlPort->Release();
     return 0;
 }
 
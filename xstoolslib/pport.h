@@ -58,6 +58,17 @@ on the parallel port pins match the values it has placed on them. This
 alerts the PPort object to any problems accessing the parallel port 
 hardware. These checks cease after a set number of I/O operations in 
 order to increase the port throughput. 
+
+The rate at which the registers of a port can be accessed is measured the 
+first time the port is opened and can be read with GetThroughput(). 
+
+By default the PPort object keeps the values of the registers in software 
+and only writes a register when its value changes. All the PPort objects 
+attached to the same port share one copy of the registers, so the FPGA, 
+RAM and flash interfaces of a board can be interleaved freely. The 
+registers are reloaded from the hardware only when Resync() is called. Setting 
+LPTnSHADOW to NO in the XSTOOLS parameter file restores the older 
+behavior of periodically rereading the registers before each output. 
 */
 class PPort : Transport
 {
@@ -81,12 +92,24 @@ class PPort : Transport
 
 	unsigned int GetLPTNum(void) const;
 
+	static double GetThroughput(unsigned int n);
+
 	void Out(unsigned int v, unsigned int loPos, unsigned int hiPos);
 
+	void OutMasked(unsigned int mask, unsigned int v);
+
 	unsigned int In(unsigned int loPos, unsigned int hiPos);
 
+	void Resync(void);
+
+	void GetIOCounts(unsigned long& writes, unsigned long& suppressed, unsigned long& reads) const;
+
+	void ResetIOCounts(void);
+
 	void SetInvMask(unsigned int mask);
 
+	unsigned int GetInvMask(void) const;
+
 	void EnableJTAG(bool value);
 
 	int StartBuffer(void);
@@ -102,12 +125,35 @@ class PPort : Transport
     int Open(unsigned int Param);
     int Close();
 
+	protected:
+
+	unsigned char PinPattern(unsigned short regOffset, unsigned int mask, unsigned int v) const;
+
+	void OutRaw(unsigned short regOffset, unsigned char byte);
+
+	unsigned char InRaw(unsigned short regOffset);
+
 	private:
 
+	/// Software copies of the parallel port registers.
+	struct RegShadow
+	{
+		unsigned int regvals;		///< store the values of the parallel port registers
+		bool valid;					///< true once regvals has been loaded from the hardware
+	};
+
+	static RegShadow& SharedShadow(unsigned int address);
+
 	unsigned char Inp(unsigned short regOffset);
 
 	void Outp(unsigned short regOffset, unsigned char byte);
 
+	void OutReg(unsigned short regOffset, unsigned int oldRegs, unsigned int newRegs);
+
+	void ReleasePorts(void);
+
+	double MeasureThroughput(void);
+
     static PPort *Singleton;
 
 	IOPort *dataPort;				///< IO port object for the parallel port data register
@@ -119,10 +165,14 @@ class PPort : Transport
 	unsigned int invMask;			///< concatenated inversion mask for data, status, and control
 	unsigned int chkCounter;		///< counts the number of initial checks to make on parallel port
 	unsigned int IODriverIndex;		///< UNIIO, DRIVERLINX, TVICHW32
-	unsigned int regvals;			///< store the values of the parallel port registers
+	RegShadow *shadow;				///< register copies shared with the other objects on this port
 	unsigned int updateCounter;		///< update regvals whenever this counter hits zero
 	bool enableJTAG;				///< true if the pin should be set to enable JTAG ops in the parallel port interface
 	bool enableJTAGPinSet;			///< true if the pin to enable JTAG ops has been set
+	bool shadowRegs;				///< true if regvals is authoritative and unchanged registers aren't rewritten
+	unsigned long writesIssued;		///< number of register writes sent to the port
+	unsigned long writesSuppressed;	///< number of register writes skipped because the register was unchanged
+	unsigned long readsIssued;		///< number of register reads from the port
 };
 
 #endif
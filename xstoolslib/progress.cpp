@@ -1,4 +1,5 @@
 #include "progress.h"
+#include "guitools.h"
 #include "utils.h"
 
 #include <unistd.h>
@@ -41,15 +42,15 @@ void Worker::DoWork()
     if (NULL != t)
     {
         connect(t, &QTimer::timeout, this, &Worker::UpdatePercentage);
-        t->start(500);
+        t->start(progressRefreshInterval);
     }
 
     //qDebug() << "Before loop...";
     Tracker->percentDone = 0;
     while (!ForceAbort)
     {
-        qSleep(100);
-        QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+        qSleep(progressRefreshInterval / 5);
+        QCoreApplication::processEvents(QEventLoop::AllEvents, progressRefreshInterval);
     }
     //qDebug() << "After loop...";
 
@@ -131,9 +132,18 @@ Progress::Progress(QObject *parent, XSError *e) :
 {
     ParentWindow = parent;
     errorChannel = e;
+    percentDone = 0;
+    cancelled = false;
 
     // progress indicator is not yet visible
     pd = NULL;
+    worker = NULL;
+
+    // the dialog and the slots that update it belong to the GUI thread even if the task runs on the I/O thread
+    if (NULL != QCoreApplication::instance())
+    {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
 }
 
 /// Create a progress indicator object.
@@ -192,51 +202,57 @@ bool Progress::Setup(string &maintaskDesc, ///< description of main task on whic
         loBound             = lo;
         hiBound             = hi;
         percentDone         = 0;
+        cancelled           = false;
         this->freeWheel     = false; //freeWheel;
+        lastEvents.start();
 
-        worker = new Worker();
-        if (NULL != worker)
+        // widgets can only be created on the GUI thread
+        GuiTools::RunOnGuiThread([&]()
         {
-            IndicatorThread = new QThread();
-            if (NULL != IndicatorThread)
+            worker = new Worker();
+            if (NULL != worker)
             {
-                string Desc;
+                IndicatorThread = new QThread();
+                if (NULL != IndicatorThread)
+                {
+                    string Desc;
 
-                worker->Setup(this);
+                    worker->Setup(this);
 
-                Desc = maintaskDescription + "\n" + subtaskDescription;
+                    Desc = maintaskDescription + "\n" + subtaskDescription;
 
-                //qDebug() << "QProgressDialog()...";
-                pd = new QProgressDialog(Desc.c_str(), "Cancel", 0, 100);
-                if (NULL != pd)
-                {
-                    //pd->setAttribute(Qt::WA_DeleteOnClose, true);
+                    //qDebug() << "QProgressDialog()...";
+                    pd = new QProgressDialog(Desc.c_str(), "Cancel", 0, 100);
+                    if (NULL != pd)
+                    {
+                        //pd->setAttribute(Qt::WA_DeleteOnClose, true);
 
-                    // Prevent overrunning the progress bar limit causing the dialog to reset & show itself again.
-                    pd->setAutoReset(false);
+                        // Prevent overrunning the progress bar limit causing the dialog to reset & show itself again.
+                        pd->setAutoReset(false);
 
-                    worker->moveToThread(IndicatorThread);
+                        worker->moveToThread(IndicatorThread);
 
-                    // Either Cancel button clicked, or the close dialog window X clicked.
-                    connect(pd, &QProgressDialog::canceled, this, &Progress::AllDone);
-                    connect(pd, &QProgressDialog::destroyed, this, &Progress::NoPD);
+                        // Either Cancel button clicked, or the close dialog window X clicked.
+                        connect(pd, &QProgressDialog::canceled, this, &Progress::AllDone);
+                        connect(pd, &QProgressDialog::destroyed, this, &Progress::NoPD);
 
-                    //connect(worker, SIGNAL(PercentageComplete(int)), pd, SLOT(setValue(int)));
-                    connect(worker, SIGNAL(PercentageComplete(int)), this, SLOT(WorkTick(int)));
-                    connect(worker, SIGNAL(WorkFinished()), this, SLOT(WorkTerminated()));
+                        //connect(worker, SIGNAL(PercentageComplete(int)), pd, SLOT(setValue(int)));
+                        connect(worker, SIGNAL(PercentageComplete(int)), this, SLOT(WorkTick(int)));
+                        connect(worker, SIGNAL(WorkFinished()), this, SLOT(WorkTerminated()));
 
-                    connect(this, SIGNAL(AbortWorkRequest()), worker, SLOT(AbortWork()));
+                        connect(this, SIGNAL(AbortWorkRequest()), worker, SLOT(AbortWork()));
 
-                    connect(IndicatorThread, SIGNAL(started()), worker, SLOT(DoWork()));
-                    connect(IndicatorThread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+                        connect(IndicatorThread, SIGNAL(started()), worker, SLOT(DoWork()));
+                        connect(IndicatorThread, SIGNAL(finished()), worker, SLOT(deleteLater()));
 
-                    connect(IndicatorThread, SIGNAL(finished()), IndicatorThread, SLOT(deleteLater()));
+                        connect(IndicatorThread, SIGNAL(finished()), IndicatorThread, SLOT(deleteLater()));
 
-                    pd->show();
+                        pd->show();
+                    }
+                    IndicatorThread->start();
                 }
-                IndicatorThread->start();
             }
-        }
+        });
 
         return true;    // setup successful
     }
@@ -249,20 +265,26 @@ bool Progress::Setup(string &maintaskDesc, ///< description of main task on whic
 /// returns true if the user has Cancelled the long activity; i.e. has ended the progress dialog.
 bool Progress::UserHasCancelled()
 {
-    return (NULL == pd);
+    return cancelled;
 }
 
-/// Display the current progress and returns true if the user has Cancelled the long activity.
+/// Record the current progress for the indicator thread to display.
+/// The GUI event loop is only run if this is the GUI thread and it hasn't run for a refresh interval.
 ///< a value between the high and low levels of the progress indicator.
 void Progress::Report(float x)
 {
-    float percent = 100 * ( x - loBound ) / ( hiBound - loBound );
+    if (!freeWheel)
+    {
+        percentDone = (int)(100 * ( x - loBound ) / ( hiBound - loBound ));
+    }
 
-    if (!freeWheel && percent > percentDone + 3)
+    if (NULL != QCoreApplication::instance()
+        && QThread::currentThread() == QCoreApplication::instance()->thread()
+        && lastEvents.elapsed() >= progressRefreshInterval)
     {
-        percentDone = percent;
+        lastEvents.restart();
+        QCoreApplication::processEvents(QEventLoop::AllEvents, progressRefreshInterval);
     }
-    QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
 }
 
 // Use this at end of the long activity to remove the progress dialog from display.
@@ -274,10 +296,16 @@ Progress *Progress::EndProgress()
     percentDone = 100;
     emit AbortWorkRequest();
 
-    if (NULL != pd)
+    GuiTools::RunOnGuiThread([&]()
     {
-        pd->close();
-    }
+        if (NULL != pd)
+        {
+            pd->close();
+        }
+
+        // drop any ticks still queued for this object so it can be deleted by the task's thread
+        QCoreApplication::removePostedEvents(this);
+    });
 
     return NULL;
 }
@@ -301,6 +329,7 @@ void Progress::AllDone()
 {
     //qDebug() << "AllDone()...";
 
+    cancelled = true;
     CloseWorker();
     if (NULL != pd)
     {
@@ -3,6 +3,7 @@
 
 #include <QtWidgets>
 #include <pthread.h>
+#include <atomic>
 
 #include "../TempFixes/FixLH.h"
 #include "../TempFixes/wtypes.h"
@@ -17,10 +18,19 @@ task that has been completed. A progress bar is displayed in a GUI
 environment while a rolling percentage indicator is used in a 
 command-line environment. 
 
+Reporting is cheap enough to do from inside a hardware loop. The task 
+only stores its percentage and reads the cancel flag, both of which are 
+atomic. The indicator thread polls the percentage at a fixed rate and 
+pushes it to the progress dialog. When the task runs on the GUI thread, 
+Report() lets the event loop run at that same rate and no faster, so 
+the dialog stays responsive however often Report() is called.
+
 */
 
 class Progress;
 
+static const int progressRefreshInterval = 50;	///< milliseconds between progress display updates (20 Hz)
+
 class Worker : public QObject
 {
     Q_OBJECT
@@ -89,8 +99,10 @@ private:
 	string subtaskDescription;	///< description of subtask within main task on which progress is currently being displayed
 	float loBound;				///< lower boundary of progress
 	float hiBound;				///< upper boundary of progress
-    volatile float percentDone;			///< current percentage of the task that is done (range 0..100)
+    std::atomic<int> percentDone;	///< current percentage of the task that is done (range 0..100)
+    std::atomic<bool> cancelled;	///< set when the user closes or cancels the progress dialog
 	bool freeWheel;				///< when true, progress indicator just recirculates to show progress is being made
+    QElapsedTimer lastEvents;	///< time since the GUI event loop was last run from Report()
 
     QThread *IndicatorThread;
     QProgressDialog *pd;
@@ -19,15 +19,24 @@
 
 
 #include <cassert>
+#include <chrono>
 #include <fstream>
+#include <vector>
 
 #include <string.h>
 
 #include "utils.h"
 #include "hexrecrd.h"
+#include "heximage.h"
+#include "uploadpipe.h"
 #include "ramport.h"
 
 
+#define	DWNLD_BUFFER_SIZE	0x80000		// maximum number of bytes in a run of contiguous download data
+
+static const unsigned int statusCheckInterval = 64;	// words written between checks of the RAM interface status
+
+
 /// Create a RAM upload/download port.
 RAMPort::RAMPort(void)
 {
@@ -84,6 +93,7 @@ int RAMPort::Setup(XSError* e,	///< pointer to error reporting object
 	posSTMSB = pos_stmsb;
 	dataWidth = dWidth;
 	addrWidth = aWidth;
+	uploadRate = 0;
 	return PPort::Setup(e,portNum,invMask);
 }
 
@@ -102,6 +112,26 @@ bool RAMPort::DownloadRAM(const char *hexfileName,	///< hex file containing the
     if(strlen(hexfileName)==0)
 		return false;  // stop if no hex file was given
 	
+	string desc("RAM Download"), subdesc("Downloading "+StripPrefix(hexfileName));
+
+	if(HexImage::CanLoad(hexfileName))
+	{ // load the whole hex or binary file at once and download it a block at a time
+		HexImage image;
+		if(!image.Load(hexfileName,err))
+			return false;
+		progressGauge = new Progress(NULL, &err);
+		if (NULL != progressGauge)
+		{
+			progressGauge->Setup(desc,subdesc,0,image.GetNumBytes());
+
+			status = DownloadRAM(image,bigEndianBytes,bigEndianBits);
+
+			delete progressGauge;
+			progressGauge = NULL;
+		}
+		return status;
+	}
+
     ifstream is(hexfileName, ios::binary);  // otherwise open hex file
 	if(!is || is.fail() || is.eof()!=0)
 	{ // error - couldn't open hex file
@@ -116,7 +146,6 @@ bool RAMPort::DownloadRAM(const char *hexfileName,	///< hex file containing the
 	streampos streamEndPos = is.tellg();	// pointer position = position of end of file
 	is.seekg(0,ios::beg);	// return pointer to beginning of file
 
-	string desc("RAM Download"), subdesc("Downloading "+StripPrefix(hexfileName));
     progressGauge = new Progress(NULL, &err);
     if (NULL != progressGauge)
     {
@@ -145,7 +174,14 @@ bool RAMPort::DownloadRAM(istream& is,	///< stream that delivers hex data to be
 	assert(progressGauge != NULL);	//	make sure progress indicator is initialized
 	progressGauge->Report(0);	// start progress indicator at zero
 
-	// read hex records from file and place data in the RAM of the board
+	// read hex records from the stream, collect the data from contiguous records into a run,
+	// and write the run to RAM when it is full or a non-contiguous record is encountered.
+	unsigned int addrScale = AddrScale();
+	unsigned int stride = 1 << addrScale;
+	vector<unsigned int> words;			// data words in the current run
+	unsigned long runAddr = 0;			// starting word address of the current run
+	unsigned long nextAddr = 0;			// byte address that continues the current run
+	words.reserve(DWNLD_BUFFER_SIZE / stride);
 	HexRecord hx;
 	while(is.eof()==0)
 	{
@@ -168,12 +204,34 @@ bool RAMPort::DownloadRAM(istream& is,	///< stream that delivers hex data to be
 			err.EndMsg();
 			break;
 		}
-		else
-		{ // send out an indication for each hex record that's loaded
-			progressGauge->Report(is.tellg());
-			if(DownloadHexRecordToRAM(hx,bigEndianBytes,bigEndianBits) == false) // download hex record
-				return false;	// an error occurred while downloading the hex record
+		if(!hx.IsData()) // skip over non-data hex records
+			continue;
+		if(!CheckHexRecordAlignment(hx))
+			return false;
+
+		// write the run if this record doesn't continue it or it is full
+		unsigned long loAddr = hx.GetAddress();
+		if((!words.empty() && loAddr != nextAddr) || (words.size()+hx.GetLength()/stride)*stride > DWNLD_BUFFER_SIZE)
+		{
+			if(!WriteRAMWords(runAddr,&words[0],words.size()))
+				return false;	// an error occurred while writing the run
+			words.clear();
 		}
+		if(words.empty())
+			runAddr = loAddr >> addrScale;
+		for(unsigned int i=0; i<hx.GetLength(); i+=stride)
+			words.push_back(Hex2Data(hx,i,stride,bigEndianBytes,bigEndianBits));	// assemble next data word from hex record
+		nextAddr = loAddr + hx.GetLength();
+
+		// send out an indication for each hex record that's loaded
+		progressGauge->Report(is.tellg());
+	}
+
+	// write whatever is left after the stream is empty
+	if(!err.IsError() && !words.empty())
+	{
+		if(!WriteRAMWords(runAddr,&words[0],words.size()))
+			return false;
 	}
 	progressGauge->Report(is.tellg());	// should set gauge to 100%
 	
@@ -181,6 +239,44 @@ bool RAMPort::DownloadRAM(istream& is,	///< stream that delivers hex data to be
 }
 
 
+/// Download the XS Board RAM with the contents of a hex image.
+///\return true if the operation was successful, false if not
+bool RAMPort::DownloadRAM(const HexImage& image,	///< data to be downloaded
+				bool bigEndianBytes,	///< if true, data is stored in RAM with most-significant byte at lower address
+				bool bigEndianBits)		///< if true, data is stored in RAM with most-significant bit in position 0
+{
+	assert(progressGauge != NULL);	//	make sure progress indicator is initialized
+	progressGauge->Report(0);	// start progress indicator at zero
+
+	// convert each extent of the image into data words and write them in runs of at most DWNLD_BUFFER_SIZE bytes
+	unsigned int addrScale = AddrScale();
+	unsigned int stride = 1 << addrScale;
+	vector<unsigned int> words;
+	words.reserve(DWNLD_BUFFER_SIZE / stride);
+	unsigned long numBytesDone = 0;
+	for(unsigned int e=0; e<image.GetNumExtents(); e++)
+	{
+		const HexExtent& extent = image.GetExtent(e);
+		if(!CheckAlignment(extent.address,extent.data.size()))
+			return false;
+		for(unsigned long i=0; i<extent.data.size(); i+=DWNLD_BUFFER_SIZE)
+		{
+			unsigned long runLength = min((unsigned long)DWNLD_BUFFER_SIZE, (unsigned long)extent.data.size()-i);
+			words.clear();
+			for(unsigned long j=0; j<runLength; j+=stride)
+				words.push_back(Hex2Data(&extent.data[i+j],stride,bigEndianBytes,bigEndianBits));
+			if(!WriteRAMWords((extent.address+i)>>addrScale,&words[0],words.size()))
+				return false;	// an error occurred while writing the run
+			numBytesDone += runLength;
+			progressGauge->Report(numBytesDone);
+		}
+	}
+	progressGauge->Report(image.GetNumBytes());	// should set gauge to 100%
+
+	return GetErr().IsError() ? false:true;
+}
+
+
 /// Upload the XS Board RAM to a file.
 ///\return true if the operation was successful, false if not
 bool RAMPort::UploadRAM(const char *hexfileName,	///< dump uploaded data to this file
@@ -197,8 +293,11 @@ bool RAMPort::UploadRAM(const char *hexfileName,	///< dump uploaded data to this
 	
     if (0 != strlen(hexfileName))
     {
-        // otherwise open hex file
-        ofstream os(hexfileName);
+        // otherwise open hex file with a big buffer so the records go to disk in large writes
+        vector<char> fileBuf(HEX_FILE_BUFFER_SIZE);
+        ofstream os;
+        os.rdbuf()->pubsetbuf(&fileBuf[0],fileBuf.size());
+        os.open(hexfileName, IsBinaryFormat(format) ? ios::out|ios::binary : ios::out);
 
         if (os.fail() || os.eof() != 0)
         {
@@ -217,6 +316,11 @@ bool RAMPort::UploadRAM(const char *hexfileName,	///< dump uploaded data to this
                 progressGauge->Setup(desc, subdesc, loAddr, hiAddr);
 
                 status = UploadRAM(os, format, loAddr, hiAddr, bigEndianBytes, bigEndianBits);
+                if (status)
+                {
+                    // record where raw data came from so it can be downloaded again
+                    status = HexImage::UpdateInfo(hexfileName, format, loAddr, hiAddr - loAddr + 1, err);
+                }
 
                 progressGauge->EndProgress();
                 delete progressGauge;
@@ -244,8 +348,12 @@ bool RAMPort::UploadRAM(ostream& os,	///< dump uploaded data to this stream
 
 	assert(progressGauge != NULL);	//	make sure progress indicator is initialized
 	progressGauge->Report(0);	// start progress indicator at zero
-	
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
 	// read hex records from RAM and place data in the hex file
+	// the records are written to the stream by another thread while the next ones are read
+	UploadPipe pipe(os,format);
 	HexRecord hx;
 	hx.Setup(format);
 	unsigned long addr;
@@ -258,7 +366,11 @@ bool RAMPort::UploadRAM(ostream& os,	///< dump uploaded data to this stream
         if (UploadHexRecordFromRAM(hx, addr, addr | 0xF, bigEndianBytes, bigEndianBits))
         {
             // send hex record to output stream
-            os << hx;
+            if (!pipe.Write(hx))
+            {
+                status = false;
+                break;
+            }
             progressGauge->Report(addr);	// give feedback on progress
         }
         else
@@ -270,88 +382,182 @@ bool RAMPort::UploadRAM(ostream& os,	///< dump uploaded data to this stream
 	}
     if (status)
     {
-        if (addr < hiAddr)
+        if (addr <= hiAddr)
         {
             // handle the last few bytes of an upload from RAM
-            status = !UploadHexRecordFromRAM(hx, addr, hiAddr, bigEndianBytes, bigEndianBits);
+            status = UploadHexRecordFromRAM(hx, addr, hiAddr, bigEndianBytes, bigEndianBits);
             if (status)
             {
-                os << hx;		// send hex record to output stream
+                status = pipe.Write(hx);		// send hex record to output stream
             }
         }
         progressGauge->Report(hiAddr);	// should set gauge to 100%
     }
+    if (!pipe.Finish())
+    {
+        err.SetSeverity(XSErrorMajor);
+        err << "could not write the uploaded RAM data\n";
+        err.EndMsg();
+        status = false;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    uploadRate = (seconds > 0) ? (hiAddr - loAddr + 1) / seconds : 0;
+    DEBUG_STMT("RAM upload " << (long)uploadRate << " bytes/s")
+
     return status;
 }
 
 
+/// Get the transfer rate of the last upload.
+///\return the number of bytes uploaded per second.
+double RAMPort::GetUploadRate(void) const
+{
+	return uploadRate;
+}
+
+
 /// Load RAM data at the addresses given in a hex record.
 ///\return true if the operation was successful, false if not
 bool RAMPort::DownloadHexRecordToRAM(HexRecord& hx,	///< hex record containing data to download to RAM
 					bool bigEndianBytes,	///< if true, data is stored in RAM with most-significant byte at lower address
 					bool bigEndianBits)		///< if true, data is stored in RAM with most-significant bit in position 0
 {
-	XSError& err = GetErr();
-
 	if(!hx.IsData()) // don't download unless this is RAM data
 		return true;	// no error, just didn't do anything
 
-	// the address has to be right-shifted by one bit for each doubling of the data width.
-	unsigned int addrScale;
+	if(!CheckHexRecordAlignment(hx))
+		return false;
+
+	unsigned int addrScale = AddrScale();
+	unsigned int stride = 1 << addrScale;
+	vector<unsigned int> words;
+	for(unsigned int i=0; i<hx.GetLength(); i+=stride)
+		words.push_back(Hex2Data(hx,i,stride,bigEndianBytes,bigEndianBits));	// assemble next data word from hex record
+	if(words.empty())
+		return true;
+	return WriteRAMWords(hx.GetAddress()>>addrScale,&words[0],words.size());
+}
+
+
+/// Get the right-shift that turns a byte address into a RAM word address.
+/// The address has to be right-shifted by one bit for each doubling of the data width.
+///\return the shift amount.
+unsigned int RAMPort::AddrScale(void) const
+{
 	if(dataWidth<=8)
-		addrScale = 0;	// addresses for byte-wide data need no scaling because each byte fits in a hex record byte
+		return 0;	// addresses for byte-wide data need no scaling because each byte fits in a hex record byte
 	else if(dataWidth<=16)
-		addrScale = 1;	// addresses for 16-bit data are halved because each word takes two bytes in the hex record
+		return 1;	// addresses for 16-bit data are halved because each word takes two bytes in the hex record
 	else if(dataWidth<=32)
-		addrScale = 2;	// addresses for 32-bit data are quartered because each word takes four bytes in the hex record
-	else
-		assert(1==0);	// we can't handle data widths > 32 bits
-	unsigned int stride = 1 << addrScale;
+		return 2;	// addresses for 32-bit data are quartered because each word takes four bytes in the hex record
+	assert(1==0);	// we can't handle data widths > 32 bits
+	return 2;
+}
 
-	unsigned int addrMask = ~((1 << addrScale) - 1);
 
-	if(hx.GetLength() % stride)
+/// Make sure the data in a hex record starts and ends on RAM word boundaries.
+///\return true if the record can be downloaded, false if not
+bool RAMPort::CheckHexRecordAlignment(HexRecord& hx)	///< hex record containing data to download to RAM
+{
+	return CheckAlignment(hx.GetAddress(),hx.GetLength());
+}
+
+
+/// Check that a block of bytes fills whole words of the RAM.
+///\return true if the block starts on a word boundary and holds a whole number of words, false if not
+bool RAMPort::CheckAlignment(unsigned long address,	///< byte address of the block
+				unsigned long length)	///< number of bytes in the block
+{
+	XSError& err = GetErr();
+	unsigned int stride = 1 << AddrScale();
+
+	if(length % stride)
 	{
 		string msg("Cannot download an odd number of bytes to word-wide RAM!\n");
 		err.SimpleMsg(XSErrorMajor,msg);
 		return false;
 	}
-	unsigned int loAddr = hx.GetAddress();
-	if(loAddr & ~addrMask)
+	if(address % stride)
 	{
 		string msg("Cannot download to word-wide RAM using an odd byte-starting address!\n");
 		err.SimpleMsg(XSErrorMajor,msg);
 		return false;
 	}
-	
+	return true;
+}
+
+
+/// Write a run of data words to consecutive RAM locations.
+/// The starting address is sent once and the words follow back-to-back. The state of the
+/// RAM interface is only checked every statusCheckInterval words and at the end of the run.
+/// If a check fails, the words since the last good check are written again with the state
+/// checked after every nybble so the address where the interface lost sync can be reported.
+///\return true if the operation was successful, false if not
+bool RAMPort::WriteRAMWords(unsigned long wordAddr,	///< RAM address of the first word
+				const unsigned int* words,	///< data words already arranged in RAM bit and byte order
+				unsigned long numWords)		///< number of words to write
+{
+	XSError& err = GetErr();
+	unsigned long failIndex;
+
+	if(WriteRAMRun(wordAddr,words,numWords,false,&failIndex))
+		return true;
+
+	// a failure of the final reset check is blamed on the last word so the retry still writes something
+	if(failIndex >= numWords)
+		failIndex = (numWords > 0) ? numWords-1 : 0;
+
+	// find the exact word that fails by repeating the unchecked part of the run
+	unsigned long retryIndex = (failIndex / statusCheckInterval) * statusCheckInterval;
+	unsigned long badIndex;
+	if(WriteRAMRun(wordAddr+retryIndex,words+retryIndex,numWords-retryIndex,true,&badIndex))
+		badIndex = failIndex;	// the retry worked, so just report where the first attempt failed
+	else
+		badIndex += retryIndex;
+
+	err.SetSeverity(XSErrorMajor);
+	err << "RAM interface lost sync while writing address " << (long)((wordAddr+badIndex) << AddrScale()) << "\n";
+	err.EndMsg();
+	return false;
+}
+
+
+/// Send the starting address and then the data words of a run to the RAM interface.
+///\return true if the operation was successful, false if not
+bool RAMPort::WriteRAMRun(unsigned long wordAddr,	///< RAM address of the first word
+				const unsigned int* words,	///< data words already arranged in RAM bit and byte order
+				unsigned long numWords,		///< number of words to write
+				bool checkEveryNybble,		///< if true, check the interface state after every nybble instead of every few words
+				unsigned long* failIndex)	///< index of the word where a state check failed
+{
+	*failIndex = 0;
+
 	Out(1,posRESET,posRESET);	// reset the downloading state machine
 	Out(0,posCLK,posCLK);		// force clock low
 	Out(0,posRESET,posRESET);	// release the reset
 	unsigned int statusChk = 0;	// set status check to reset state id
 	unsigned int status = In(posSTLSB,posSTMSB);
-	assert(status==statusChk);	// make sure we are in reset state
 	if(status != statusChk)
 		return false;	// error - couldn't reset RAM interface state machine
 	
-	unsigned int address = loAddr >> addrScale;	// get starting address for hex record
 	int j;
 	for(j=addrWidth-4; j>=0; j-=4)
 	{
-		Out((address>>j)&0xf,posDOLSB,posDOMSB);
+		Out((wordAddr>>j)&0xf,posDOLSB,posDOMSB);
 		Out(1,posCLK,posCLK);	// latch 4 address bits into downloading circuit
 		statusChk++;			// increment status check but don't check it
 		Out(0,posCLK,posCLK);
 	}
 	status = In(posSTLSB,posSTMSB);
-	assert(status==statusChk);
 	if(status != statusChk)
 		return false;	// error - RAM interface state machine not in the right state
 	
-	// process the bytes from a data-type hex record
 	unsigned int statusChkSave = statusChk;
-	for(unsigned int i=0; i<hx.GetLength(); i+=stride)
+	for(unsigned long w=0; w<numWords; w++)
 	{
-		unsigned int data = Hex2Data(hx,i,stride,bigEndianBytes,bigEndianBits);	// assemble next data word from hex record
+		*failIndex = w;
+		unsigned int data = words[w];
 		for(j=dataWidth-4; j>0; j-=4)
 		{
 			Out((data>>j)&0xf,posDOLSB,posDOMSB);
@@ -362,29 +568,30 @@ bool RAMPort::DownloadHexRecordToRAM(HexRecord& hx,	///< hex record containing d
 				Out(data&0xf,posDOLSB,posDOMSB);
 			statusChk++;				// increment to next state id
 			Out(0,posCLK,posCLK);
-			status = In(posSTLSB,posSTMSB);
-			assert(status==statusChk);
-			if(status != statusChk)
-				return false;	// error - RAM interface state machine not in the right state
+			if(checkEveryNybble)
+			{
+				status = In(posSTLSB,posSTMSB);
+				if(status != statusChk)
+					return false;	// error - RAM interface state machine not in the right state
+			}
 		}
 		Out(1,posCLK,posCLK);		// terminate RAM write pulse
 		statusChk = statusChkSave;	// loop status check once data word is downloaded
 		Out(0,posCLK,posCLK);
-		status = In(posSTLSB,posSTMSB);
-		assert(status==statusChk);
-		if(status != statusChk)
-			return false;	// error - RAM interface state machine not in the right state
+		if(checkEveryNybble || (w+1)%statusCheckInterval == 0 || w+1 == numWords)
+		{
+			status = In(posSTLSB,posSTMSB);
+			if(status != statusChk)
+				return false;	// error - RAM interface state machine not in the right state
+		}
 	}
 	
 	Out(1,posRESET,posRESET);	// reset the downloading state machine
 	Out(0,posRESET,posRESET);	// release the reset
 	statusChk = 0;				// set status check to reset state id
 	status = In(posSTLSB,posSTMSB);
-	assert(status==statusChk);	// make sure we are in reset state
-	if(status != statusChk)
-		return false;	// error - RAM interface state machine not in the right state
-	else
-		return true;
+	*failIndex = numWords;
+	return status == statusChk;
 }
 
 
@@ -500,7 +707,8 @@ bool RAMPort::UploadHexRecordFromRAM(HexRecord& hx,	///< hex record to store dat
 
 	hx.SetAddress(loAddr);	// set beginning and ending addresses for the hex record
 	hx.SetLength(hiAddr-loAddr+stride);
-	
+
+
 	Out(1,posRESET,posRESET);	// reset the downloading state machine
 	Out(0,posCLK,posCLK);		// force clock low
 	Out(0,posRESET,posRESET);	// release the reset
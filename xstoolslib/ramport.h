@@ -24,6 +24,7 @@
 #include "progress.h"
 #include "pport.h"
 #include "hexrecrd.h"
+#include "heximage.h"
 
 #define BIG_ENDIAN_BYTES	true
 #define	LITTLE_ENDIAN_BYTES	false
@@ -49,12 +50,18 @@ machine which re-assembles them and then loads the data into the given
 address location in RAM. The state machine returns an indicator of its 
 current state through the parallel port status lines so the download 
 method can detect any loss of synchronization during the RAM download. 
+Data from contiguous hex records is collected into runs, so the address 
+is only sent once per run, and the state is only checked every few words. 
+If a check fails, the unchecked words are written again with a check 
+after every nybble to find the address where synchronization was lost. 
 
 The upload method works in a similar fashion. It passes an address 
 through the parallel port to the state machine in the XS Board FPGA or 
 CPLD. The data from the given address Flash memory is returned 
 while the upload method is sending the next memory address. 
 
+The transfer rate of the last upload can be read with GetUploadRate(). 
+
 */
 class RAMPort : public PPort
 {
@@ -78,6 +85,8 @@ class RAMPort : public PPort
 
 	bool DownloadRAM(istream& is, bool bigEndianBytes, bool bigEndianBits);
 
+	bool DownloadRAM(const HexImage& image, bool bigEndianBytes, bool bigEndianBits);
+
     bool UploadRAM(const char *hexfileName, const char* format, unsigned long loAddr,
 		unsigned long hiAddr, bool bigEndianBytes, bool bigEndianBits);
 
@@ -95,6 +104,8 @@ class RAMPort : public PPort
 	bool ReadRAM(unsigned int addr, unsigned int* data,
 		bool bigEndianBytes, bool bigEndianBits);
 
+	double GetUploadRate(void) const;
+
 
 	protected:
 
@@ -103,6 +114,17 @@ class RAMPort : public PPort
 	
 	private:
 
+	unsigned int AddrScale(void) const;
+
+	bool CheckHexRecordAlignment(HexRecord& hx);
+
+	bool CheckAlignment(unsigned long address, unsigned long length);
+
+	bool WriteRAMWords(unsigned long wordAddr, const unsigned int* words, unsigned long numWords);
+
+	bool WriteRAMRun(unsigned long wordAddr, const unsigned int* words, unsigned long numWords,
+		bool checkEveryNybble, unsigned long* failIndex);
+
 	unsigned int posRESET;	///< bit position in parallel port of RAM RESET pin
 	unsigned int posCLK;	///< bit position in parallel port of RAM CLK pin
 	unsigned int posDOLSB;	///< bit position in parallel port of LSB of RAM data-out pin
@@ -113,6 +135,7 @@ class RAMPort : public PPort
 	unsigned int posSTMSB;	///< bit position in parallel port of MSB of RAM status pin
 	unsigned int dataWidth;	///< width of RAM data
 	unsigned int addrWidth;	///< width of RAM address
+	double uploadRate;		///< bytes per second for the last upload
 };
 
 #endif
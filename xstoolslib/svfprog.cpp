@@ -0,0 +1,756 @@
+/*----------------------------------------------------------------------------------
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+	02111-1307, USA.
+
+	1997-2010 - X Engineering Software Systems Corp.
+----------------------------------------------------------------------------------*/
+
+
+
+#include <fstream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+#include "svfprog.h"
+#include "enum.h"
+
+
+// This is a list of all JTAG SVF command words implemented in here.
+// For the name of each enum, use the exact text and case as per used in the SVF file.
+BETTER_ENUM(KeyWordSvf, char,  \
+    TRST = 1,               \
+    PIO,                    \
+    PIOMAP,                 \
+    FREQUENCY,              \
+    ENDIR,                  \
+    ENDDR,                  \
+    STATE,                  \
+    HIR,                    \
+    HDR,                    \
+    TIR,                    \
+    TDR,                    \
+    TDI,                    \
+    SIR,                    \
+    SDR,                    \
+    RUNTEST)
+
+// Use this function to map an SVF key word into a int code that can be used for switch() statement.
+// A return value of 0 means key word not recognised
+static int GetSvfKeyCode(const char *SvfCmdWord)
+{
+    int Code;
+
+    Code = 0;
+    for (KeyWordSvf c : KeyWordSvf::_values())
+    {
+        if (0 == strcmp(c._to_string(), SvfCmdWord))
+        {
+            // Thats the command code to use.
+            Code = c;
+            break;
+        }
+    }
+    return Code;
+}
+
+
+// Cache files start with this identifier. Change the version character if the layout or the optimizer changes.
+static const char cacheMagic[8] = {'X','S','S','V','F','C','5',0};
+
+static const char* cacheSuffix = ".svfc";	// appended to the SVF file name to get the cache file name
+
+
+// Write an integer to a cache file as little-endian bytes.
+static void PutInt(ostream& os, unsigned long long v, unsigned int nBytes)
+{
+	for(unsigned int i=0; i<nBytes; i++, v>>=8)
+		os.put((char)(v & 0xFF));
+}
+
+
+// Read a little-endian integer from a cache file.
+static unsigned long long GetInt(istream& is, unsigned int nBytes)
+{
+	unsigned long long v = 0;
+	for(unsigned int i=0; i<nBytes; i++)
+		v |= (unsigned long long)(is.get() & 0xFF) << (8*i);
+	return v;
+}
+
+
+// Load the bits of an SVF hex field like "(1F3A)" into a bitstream.
+static void GetHexField(SVFReader& svf, unsigned long len, Bitstream& b)
+{
+	SVFWord word = svf.NextWord();
+	assert(word.ptr[0]=='(');
+	assert(word.ptr[word.len-1]==')');
+	b.FromHexString(len,word.ptr,word.len);
+}
+
+
+// Make a bitstream of all ones.
+static void SetAllOnes(Bitstream& b, unsigned long len)
+{
+	b.Resize(len);
+	unsigned long* w = b.GetWords();
+	for(unsigned int i=0; i*Bitstream::GetBitsPerWord() < len; i++)
+		w[i] = ~0UL;
+}
+
+
+// Get the number of bits in an SVF command and load the bits of its TDI, TDO and MASK fields.
+// TDI and MASK keep their previous values if they're not in the command, but MASK goes back
+// to all ones (compare every bit) if the length changes. TDO is only compared for commands
+// that have a TDO field. The TDO and MASK fields of headers and trailers are skipped.
+static unsigned long GetFields(SVFReader& svf, Bitstream& tdi, Bitstream* tdo, Bitstream* mask, bool& hasTDO)
+{
+	int status;
+	unsigned long len;
+
+	status = sscanf(svf.NextWord().ToString().c_str(),"%lu",&len);
+	assert(status!=0);
+
+	if(mask != NULL && mask->GetLength() != len)
+		SetAllOnes(*mask, len);
+	tdi.Resize(len);
+	hasTDO = false;
+	if(len == 0)
+		return len;
+
+	for(SVFWord word = svf.NextWord(); !word.IsEmpty(); word = svf.NextWord())
+	{
+		if(word.Is("TDI"))
+			GetHexField(svf, len, tdi);
+		else if(word.Is("TDO") && tdo != NULL)
+		{
+			GetHexField(svf, len, *tdo);
+			hasTDO = true;
+		}
+		else if(word.Is("MASK") && mask != NULL)
+			GetHexField(svf, len, *mask);
+		else
+			svf.NextWord();	// skip the bits of a field that isn't used
+	}
+	return len;
+}
+
+
+/// Create an empty SVF program.
+SVFProgram::SVFProgram(void) : hir(0), hdr(0), tir(0), tdr(0), sir(0), sdr(0),
+	sirTDO(0), sdrTDO(0), sirMask(0), sdrMask(0)
+{
+	sourceLength = 0;
+	optimized = false;
+	endir = enddr = RunTestIdle;
+	optState = RunTestIdle;		// downloads start in Run-Test/Idle
+	optIR = -1;
+	tcksSaved = 0;
+}
+
+
+/// Remove all the operations and bitstreams from the program.
+/// The header, trailer and end states set by earlier SVF commands are kept so
+/// the following commands of the same file can still be compiled. The optimizer
+/// starts over since the bitstream it had in the IR is gone.
+void SVFProgram::Clear(void)
+{
+	ops.clear();
+	bitstreams.clear();
+	spare.clear();
+	optState = RunTestIdle;
+	optIR = -1;
+}
+
+
+/// Remove all the operations and bitstreams from the program but keep their storage.
+/// The bitstreams of the next shifts are built in the storage of the released ones, so
+/// compiling one command at a time doesn't allocate once the storage is large enough.
+void SVFProgram::Reuse(void)
+{
+	for(unsigned int i=bitstreams.size(); i>0; i--)
+		spare.push_back(std::move(bitstreams[i-1]));	// the first bitstream is reused first
+	ops.clear();
+	bitstreams.clear();
+	optState = RunTestIdle;
+	optIR = -1;
+}
+
+
+// Append an operation to a list of operations.
+void SVFProgram::AddOp(vector<SVFOp>& opList, SVFOpCode code, TAPState state, unsigned int arg, unsigned long position)
+{
+	SVFOp op;
+	op.code = code;
+	op.state = state;
+	op.arg = arg;
+	op.position = position;
+	opList.push_back(op);
+}
+
+
+// Append an empty bitstream to the program, reusing the storage of a released one if there is one.
+Bitstream& SVFProgram::NewBitstream(void)
+{
+	if(spare.empty())
+		bitstreams.push_back(Bitstream(0));
+	else
+	{
+		bitstreams.push_back(std::move(spare.back()));
+		spare.pop_back();
+	}
+	return bitstreams.back();
+}
+
+
+// Append a shift of the concatenated header, data and trailer bits to the program.
+void SVFProgram::AddShift(SVFOpCode code, TAPState endState, const Bitstream& head, const Bitstream& data, const Bitstream& tail, unsigned long position)
+{
+	NewBitstream().Concatenate(head, data, tail);
+	AddOp(ops, code, endState, bitstreams.size()-1, position);
+}
+
+
+// Append a shift whose TDO bits are compared with the expected bits under a mask.
+// The expected and mask bitstreams follow the sent bits, and the mask is zero for the
+// header and trailer bits so only the bits of the register itself are compared.
+void SVFProgram::AddVerifiedShift(SVFOpCode code, TAPState endState, const Bitstream& head, const Bitstream& data, const Bitstream& tail,
+								const Bitstream& tdo, const Bitstream& mask, unsigned long position)
+{
+	Bitstream headZeros(head.GetLength()), tailZeros(tail.GetLength());
+
+	AddShift(code, endState, head, data, tail, position);
+	NewBitstream().Concatenate(headZeros, tdo, tailZeros);
+	NewBitstream().Concatenate(headZeros, mask, tailZeros);
+}
+
+
+/// Compile the current command of an SVF reader and append its operations to the program.
+///\return true if the command was compiled, false if it was not understood.
+bool SVFProgram::CompileCommand(SVFReader& svf,	///< reader positioned on the command to compile
+						XSError& err)			///< error reporting channel
+{
+	// remove the first keyword from the command
+	string keywd(svf.NextWord().ToString());
+	if(keywd == "")
+		return true;	// must be a blank line
+
+	unsigned long position = svf.GetPosition();
+	unsigned long len;
+	int status;
+	bool hasTDO;
+
+	switch(GetSvfKeyCode(keywd.c_str()))
+	{
+	case KeyWordSvf::_from_string("TRST"):
+	case KeyWordSvf::_from_string("PIO"):
+	case KeyWordSvf::_from_string("PIOMAP"):
+	case KeyWordSvf::_from_string("FREQUENCY"):
+		// these commands have nothing to do with configuration so ignore them
+		break;
+
+	case KeyWordSvf::_from_string("ENDIR"):
+		{
+			string nw = svf.NextWord().ToString();
+			assert(nw != "");
+			endir = JTAGPort::LabelToTAPState(nw);
+			break;
+		}
+
+	case KeyWordSvf::_from_string("ENDDR"):
+		{
+			string nw = svf.NextWord().ToString();
+			assert(nw != "");
+			enddr = JTAGPort::LabelToTAPState(nw);
+			break;
+		}
+
+	case KeyWordSvf::_from_string("STATE"):
+		{
+			string s;
+			for(s = svf.NextWord().ToString(); s != ""; s = svf.NextWord().ToString())
+				AddOp(ops, SVFOpState, JTAGPort::LabelToTAPState(s), 0, position);
+			break;
+		}
+
+	case KeyWordSvf::_from_string("HIR"):
+		GetFields(svf, hir, NULL, NULL, hasTDO);	// header bits for loading into the IR
+		break;
+
+	case KeyWordSvf::_from_string("HDR"):
+		GetFields(svf, hdr, NULL, NULL, hasTDO);	// header bits for loading into the DR
+		break;
+
+	case KeyWordSvf::_from_string("TIR"):
+		GetFields(svf, tir, NULL, NULL, hasTDO);	// trailer bits for loading into the IR
+		break;
+
+	case KeyWordSvf::_from_string("TDR"):
+		GetFields(svf, tdr, NULL, NULL, hasTDO);	// trailer bits for loading into the DR
+		break;
+
+	case KeyWordSvf::_from_string("SIR"):
+		// send header, instruction, and trailer bits into the IR
+		len = GetFields(svf, sir, &sirTDO, &sirMask, hasTDO);
+		assert(len>0);
+		if(hasTDO)
+			AddVerifiedShift(SVFOpVerifyIR, endir, hir, sir, tir, sirTDO, sirMask, position);
+		else
+			AddShift(SVFOpShiftIR, endir, hir, sir, tir, position);
+		break;
+
+	case KeyWordSvf::_from_string("SDR"):
+		// send header, data, and trailer bits into the DR
+		len = GetFields(svf, sdr, &sdrTDO, &sdrMask, hasTDO);
+		assert(len>0);
+		if(hasTDO)
+			AddVerifiedShift(SVFOpVerifyDR, enddr, hdr, sdr, tdr, sdrTDO, sdrMask, position);
+		else
+			AddShift(SVFOpShiftDR, enddr, hdr, sdr, tdr, position);
+		break;
+
+	case KeyWordSvf::_from_string("RUNTEST"):
+		// get the number of TCK pulses to wait while programming takes place
+		status = sscanf(svf.NextWord().ToString().c_str(),"%lu",&len);
+		assert(status!=0);
+		assert(svf.NextWord().Is("TCK"));
+		AddOp(ops, SVFOpRunTest, InvalidTAPState, len, position);
+		break;
+
+	default:
+		// if we get here, then it's some strange junk we don't understand
+		err.SetSeverity(XSErrorMajor);
+		err << (string)"unknown SVF command: " << keywd << (string)"\n";
+		err.EndMsg();
+		return false;
+	}
+	return true;
+}
+
+
+/// Compile an entire SVF file into a program.
+///\return true if the file was compiled, false if it had errors.
+bool SVFProgram::Compile(istream& is,	///< stream delivering the SVF file
+						XSError& err)	///< error reporting channel
+{
+	*this = SVFProgram();
+
+	SVFReader svf(is);
+	while(svf.NextCommand())
+	{
+		if(!CompileCommand(svf, err))
+			return false;
+	}
+	sourceLength = svf.GetPosition();
+	return true;
+}
+
+
+/// Remove redundant work from the operations added to the program since a given operation.
+/// The optimizer tracks the TAP state and the instruction in the IR as the program runs and:
+///  - drops SIR shifts that reload the instruction the IR already holds,
+///  - drops STATE moves to the state the TAP is already in and RUNTESTs of zero clocks,
+///  - turns verified shifts whose mask is all zeros into plain shifts (no TDO capture).
+/// The end states of the shifts are never changed, so every Run-Test/Idle visit the SVF asks for is kept.
+/// Adjacent RUNTESTs aren't merged, since the port may wait instead of pulsing TCK for long
+/// RUNTESTs and a merged one could cross from one to the other.
+/// The tracked state carries over from one call to the next, so the commands of an SVF file
+/// can be optimized as they are compiled and performed.
+void SVFProgram::OptimizeOps(unsigned int firstOp)	///< index of the first operation to optimize
+{
+	unsigned int n = firstOp;	// number of operations kept
+
+	for(unsigned int i=firstOp; i<ops.size(); i++)
+	{
+		SVFOp op = ops[i];
+		switch(op.code)
+		{
+		case SVFOpState:
+			if(op.state == optState)
+				continue;	// already there
+			if(op.state == TestLogicReset)
+				optIR = -1;	// reset loads the IR with IDCODE or BYPASS
+			optState = (TAPState)op.state;
+			break;
+
+		case SVFOpRunTest:
+			if(op.arg == 0)
+				continue;
+			break;
+
+		case SVFOpVerifyIR:
+		case SVFOpVerifyDR:
+			{
+				// the IR holds the new instruction whether or not its TDO bits are checked
+				if(op.code == SVFOpVerifyIR)
+					optIR = op.arg;
+
+				// a zero mask compares nothing: (mask ^ 0) & mask is zero only if the mask is all zeros
+				const Bitstream& mask = bitstreams[op.arg+2];
+				Bitstream zeros(mask.GetLength());
+				if(mask.MaskedCompare(zeros, mask))
+					op.code = (op.code == SVFOpVerifyIR) ? SVFOpShiftIR : SVFOpShiftDR;
+			}
+			optState = (TAPState)op.state;
+			break;
+
+		case SVFOpShiftIR:
+			if(optIR >= 0 && bitstreams[op.arg] == bitstreams[optIR])
+			{
+				// the IR already holds this instruction
+				tcksSaved += JTAGPort::GetTAPPathLength(optState, ShiftIR) + bitstreams[op.arg].GetLength()
+					+ JTAGPort::GetTAPPathLength(Exit1IR, (TAPState)op.state);
+				if(op.state != optState)
+				{
+					tcksSaved -= JTAGPort::GetTAPPathLength(optState, (TAPState)op.state);
+					op.code = SVFOpState;	// just go to the end state of the shift
+					op.arg = 0;
+					optState = (TAPState)op.state;
+					break;
+				}
+				continue;
+			}
+			optIR = op.arg;
+			optState = (TAPState)op.state;
+			break;
+
+		case SVFOpShiftDR:
+			optState = (TAPState)op.state;
+			break;
+		}
+		ops[n++] = op;
+	}
+	ops.resize(n);
+}
+
+
+/// Remove redundant work from the program and drop the bitstreams that are no longer used.
+/// A program whose operations were already passed through OptimizeOps() as they were compiled
+/// is left with the same operations, so this only releases the unused bitstreams.
+///\return the number of TCK pulses removed from the program.
+unsigned long SVFProgram::Optimize(void)
+{
+	optState = RunTestIdle;	// downloads start in Run-Test/Idle
+	optIR = -1;
+	OptimizeOps(0);
+
+	// keep only the bitstreams that are still used
+	vector<Bitstream> used;
+	for(unsigned int i=0; i<ops.size(); i++)
+	{
+		unsigned int n;
+		switch(ops[i].code)
+		{
+		case SVFOpShiftIR:
+		case SVFOpShiftDR:
+			n = 1;
+			break;
+		case SVFOpVerifyIR:
+		case SVFOpVerifyDR:
+			n = 3;
+			break;
+		default:
+			n = 0;
+			break;
+		}
+		if(n == 0)
+			continue;
+		unsigned int first = used.size();
+		for(unsigned int j=0; j<n; j++)
+			used.push_back(std::move(bitstreams[ops[i].arg+j]));
+		ops[i].arg = first;
+	}
+
+	bitstreams.swap(used);
+	optimized = true;
+	return tcksSaved;
+}
+
+
+/// Get the number of TCK pulses removed from the program by the optimizer.
+unsigned long SVFProgram::GetTCKsSaved(void) const
+{
+	return tcksSaved;
+}
+
+
+/// Get the number of operations in the program.
+unsigned int SVFProgram::GetNumOps(void) const
+{
+	return ops.size();
+}
+
+
+/// Get an operation from the program.
+const SVFOp& SVFProgram::GetOp(unsigned int i) const	///< index of the operation
+{
+	return ops[i];
+}
+
+
+/// Get the bits for a shift operation.
+Bitstream& SVFProgram::GetBitstream(unsigned int i)	///< bitstream index from the arg field of the operation
+{
+	return bitstreams[i];
+}
+
+
+/// Get the length of the SVF file the program was compiled from.
+unsigned long SVFProgram::GetSourceLength(void) const
+{
+	return sourceLength;
+}
+
+
+/// Record the length of the SVF file the program was compiled from.
+void SVFProgram::SetSourceLength(unsigned long n)	///< number of characters in the SVF file
+{
+	sourceLength = n;
+}
+
+
+/// Load a program from a cache file.
+///\return true if the cache file was for an SVF file with the given stamp and was optimized
+/// (or not) as requested, false otherwise.
+bool SVFProgram::Load(const char* cacheFileName,	///< file holding the compiled program
+					unsigned long long stamp,		///< stamp of the SVF file from Stamp()
+					bool optimize)					///< true if the program should have been optimized
+{
+	ifstream is(cacheFileName, ios::binary);
+	if(!is)
+		return false;
+
+	char magic[sizeof(cacheMagic)];
+	is.read(magic, sizeof(magic));
+	if(is.fail() || memcmp(magic, cacheMagic, sizeof(magic)) != 0)
+		return false;
+	if(GetInt(is,8) != stamp)
+		return false;	// SVF file has changed since the cache was made
+	if((GetInt(is,1) != 0) != optimize)
+		return false;
+
+	*this = SVFProgram();
+	optimized = optimize;
+	sourceLength = GetInt(is,4);
+	unsigned int numBitstreams = GetInt(is,4);
+	unsigned int numOps = GetInt(is,4);
+	if(is.fail())
+		return false;
+
+	vector<unsigned char> chars;
+	bitstreams.reserve(numBitstreams);
+	for(unsigned int i=0; i<numBitstreams && !is.fail(); i++)
+	{
+		unsigned int nBits = GetInt(is,4);
+		chars.resize((nBits+7)/8 + 1);
+		is.read((char*)&chars[0], (nBits+7)/8);
+		bitstreams.push_back(Bitstream(0));
+		bitstreams.back().FromCharString(nBits, &chars[0]);
+	}
+
+	bool ok = true;
+	ops.resize(numOps);
+	for(unsigned int i=0; i<numOps && ok; i++)
+	{
+		ops[i].code = GetInt(is,1);
+		ops[i].state = GetInt(is,1);
+		ops[i].arg = GetInt(is,4);
+		ops[i].position = GetInt(is,4);
+		if(ops[i].code > SVFOpVerifyDR || ops[i].state > InvalidTAPState
+			|| ((ops[i].code==SVFOpShiftIR || ops[i].code==SVFOpShiftDR) && ops[i].arg >= numBitstreams)
+			|| ((ops[i].code==SVFOpVerifyIR || ops[i].code==SVFOpVerifyDR) && ops[i].arg+2 >= numBitstreams))
+			ok = false;	// corrupted cache file
+		ok = ok && !is.fail();
+	}
+
+	if(!ok || is.get() != EOF)
+	{
+		Clear();
+		return false;
+	}
+	return true;
+}
+
+
+/// Save a program to a cache file.
+/// The program is written to a temporary file that is then renamed, so another process
+/// loading the same cache never sees a partly-written file.
+///\return true if the cache file was written, false otherwise.
+bool SVFProgram::Save(const char* cacheFileName,	///< file to hold the compiled program
+					unsigned long long stamp) const	///< stamp of the SVF file from Stamp()
+{
+	char pid[20];
+	sprintf(pid, ".%d", (int)getpid());
+	string tmpFileName = (string)cacheFileName + pid;
+
+	ofstream os(tmpFileName.c_str(), ios::binary);
+	if(!os)
+		return false;
+
+	os.write(cacheMagic, sizeof(cacheMagic));
+	PutInt(os, stamp, 8);
+	PutInt(os, optimized ? 1 : 0, 1);
+	PutInt(os, sourceLength, 4);
+	PutInt(os, bitstreams.size(), 4);
+	PutInt(os, ops.size(), 4);
+
+	for(unsigned int i=0; i<bitstreams.size(); i++)
+	{
+		unsigned int nBits = bitstreams[i].GetLength();
+		PutInt(os, nBits, 4);
+		unsigned char* chars = bitstreams[i].ToCharString();
+		if(chars != NULL)
+			os.write((char*)chars, (nBits+7)/8);
+		delete [] chars;
+	}
+
+	for(unsigned int i=0; i<ops.size(); i++)
+	{
+		PutInt(os, ops[i].code, 1);
+		PutInt(os, ops[i].state, 1);
+		PutInt(os, ops[i].arg, 4);
+		PutInt(os, ops[i].position, 4);
+	}
+
+	os.close();
+	if(os.fail() || rename(tmpFileName.c_str(), cacheFileName) != 0)
+	{
+		remove(tmpFileName.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+/// Compute a 64-bit FNV-1a hash of the size and modification time of a file.
+/// The file contents aren't read, so checking the cache doesn't delay the start of a download.
+///\return the stamp value, or 0 if the file can't be found.
+unsigned long long SVFProgram::Stamp(const char* svfFileName)	///< name of the SVF file
+{
+	struct stat info;
+	if(stat(svfFileName, &info) != 0)
+		return 0;
+
+	unsigned long long fields[3] = {(unsigned long long)info.st_size,
+		(unsigned long long)info.st_mtim.tv_sec, (unsigned long long)info.st_mtim.tv_nsec};
+	unsigned long long h = 0xcbf29ce484222325ULL;
+	for(unsigned int f=0; f<3; f++)
+		for(unsigned int i=0; i<8; i++)
+		{
+			h ^= (fields[f] >> (8*i)) & 0xFF;
+			h *= 0x100000001b3ULL;
+		}
+	return h ? h : 1;	// 0 is reserved for a missing file
+}
+
+
+/// Get the name of the cache file for an SVF file.
+///\return the cache file name.
+string SVFProgram::CacheFileName(const char* svfFileName)	///< name of the SVF file
+{
+	return (string)svfFileName + cacheSuffix;
+}
+
+
+/// Compile an SVF file and store the program in its cache file.
+///\return true if the cache file was written, false otherwise.
+bool SVFProgram::CompileFile(const char* svfFileName,	///< name of the SVF file
+							XSError& err,				///< error reporting channel
+							bool optimize,				///< if true, remove redundant operations from the program
+							unsigned long& tcksSaved)	///< number of TCK pulses removed by the optimizer
+{
+	tcksSaved = 0;
+
+	ifstream is(svfFileName, ios::binary);
+	if(!is)
+	{
+		err.SetSeverity(XSErrorMajor);
+		err << "could not open " << svfFileName << "\n";
+		err.EndMsg();
+		return false;
+	}
+
+	unsigned long long stamp = Stamp(svfFileName);
+	SVFProgram prog;
+	if(!prog.Compile(is, err))
+		return false;
+	if(optimize)
+		tcksSaved = prog.Optimize();
+
+	string cacheFileName = CacheFileName(svfFileName);
+	if(!prog.Save(cacheFileName.c_str(), stamp))
+	{
+		err.SetSeverity(XSErrorMajor);
+		err << "could not write " << cacheFileName << "\n";
+		err.EndMsg();
+		return false;
+	}
+	return true;
+}
+
+
+/// Compile every SVF file in a directory and its subdirectories into cache files.
+///\return the number of SVF files that were compiled.
+unsigned int SVFProgram::CompileTree(const char* dirName,	///< top of the directory tree (e.g. XessData)
+									XSError& err,			///< error reporting channel
+									ostream& os,			///< the name of each compiled file is listed here
+									bool optimize)			///< if true, remove redundant operations from the programs
+{
+	DIR* dir = opendir(dirName);
+	if(dir == NULL)
+	{
+		err.SetSeverity(XSErrorMajor);
+		err << "could not open directory " << dirName << "\n";
+		err.EndMsg();
+		return 0;
+	}
+
+	unsigned int numCompiled = 0;
+	struct dirent* entry;
+	while((entry = readdir(dir)) != NULL)
+	{
+		string name(entry->d_name);
+		if(name == "." || name == "..")
+			continue;
+
+		string path = (string)dirName + "/" + name;
+		struct stat info;
+		if(stat(path.c_str(), &info) != 0)
+			continue;
+
+		if(S_ISDIR(info.st_mode))
+			numCompiled += CompileTree(path.c_str(), err, os, optimize);
+		else if(S_ISREG(info.st_mode) && name.length() > 4
+			&& strcasecmp(name.c_str()+name.length()-4, ".svf") == 0)
+		{
+			unsigned long tcksSaved;
+			if(CompileFile(path.c_str(), err, optimize, tcksSaved))
+			{
+				os << "compiled " << path;
+				if(optimize)
+					os << " (" << tcksSaved << " TCKs saved)";
+				os << "\n";
+				numCompiled++;
+			}
+		}
+	}
+	closedir(dir);
+	return numCompiled;
+}
@@ -0,0 +1,155 @@
+/*----------------------------------------------------------------------------------
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+	02111-1307, USA.
+
+	1997-2010 - X Engineering Software Systems Corp.
+----------------------------------------------------------------------------------*/
+
+
+
+#ifndef SVFPROG_H
+#define SVFPROG_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "xserror.h"
+#include "bitstrm.h"
+#include "svfread.h"
+#include "jtagport.h"
+
+
+/// Identifiers for the operations in a compiled SVF program.
+typedef enum
+{
+	SVFOpState=0,	///< move the TAP to a state
+	SVFOpShiftIR=1,	///< shift a bitstream into the IR and then go to an end state
+	SVFOpShiftDR=2,	///< shift a bitstream into the DR and then go to an end state
+	SVFOpRunTest=3,	///< pulse TCK while holding the TAP in its current state
+	SVFOpVerifyIR=4,	///< shift into the IR and compare the TDO bits with the expected bits
+	SVFOpVerifyDR=5		///< shift into the DR and compare the TDO bits with the expected bits
+}SVFOpCode;
+
+
+/// A single JTAG operation from a compiled SVF program.
+struct SVFOp
+{
+	unsigned char code;		///< SVFOpCode for the operation
+	unsigned char state;	///< TAP state to go to (or end state after a shift)
+	unsigned int arg;		///< bitstream index for shifts (expected TDO and mask follow for verified shifts), number of TCK pulses for RUNTEST
+	unsigned long position;	///< position in the SVF file just after the command (for progress)
+};
+
+
+/**
+An SVF file compiled into a list of JTAG operations.
+
+This object turns SVF commands into a compact list of TAP moves, shifts
+and RUNTEST pulses. The header, trailer and register bits of each SIR
+and SDR command are concatenated once when the command is compiled, so
+playing the program only has to move the TAP and shift the stored
+bitstreams. TDO is only captured for SIR and SDR commands that have a
+TDO field, and it is compared with the expected bits under the MASK
+field a word at a time. When the commands are played as they are compiled 
+and the program isn't kept, Reuse() empties it between commands while 
+keeping the storage of its bitstreams for the next ones.
+
+A compiled program can be saved to a cache file next to its SVF file.
+The cache is keyed by a stamp made from the size and modification time
+of the SVF file, so it is used only as long as the SVF file is unchanged and later downloads of the
+same file don't have to parse it at all. Cached programs are optimized
+to remove redundant IR loads, TAP moves and RUNTEST commands.
+
+*/
+class SVFProgram
+{
+	public:
+
+	SVFProgram(void);
+
+	void Clear(void);
+
+	void Reuse(void);
+
+	bool CompileCommand(SVFReader& svf, XSError& err);
+
+	bool Compile(istream& is, XSError& err);
+
+	unsigned int GetNumOps(void) const;
+
+	const SVFOp& GetOp(unsigned int i) const;
+
+	Bitstream& GetBitstream(unsigned int i);
+
+	unsigned long GetSourceLength(void) const;
+
+	void SetSourceLength(unsigned long n);
+
+	void OptimizeOps(unsigned int firstOp);
+
+	unsigned long Optimize(void);
+
+	unsigned long GetTCKsSaved(void) const;
+
+	bool Load(const char* cacheFileName, unsigned long long stamp, bool optimize);
+
+	bool Save(const char* cacheFileName, unsigned long long stamp) const;
+
+	static unsigned long long Stamp(const char* svfFileName);
+
+	static string CacheFileName(const char* svfFileName);
+
+	static bool CompileFile(const char* svfFileName, XSError& err, bool optimize, unsigned long& tcksSaved);
+
+	static unsigned int CompileTree(const char* dirName, XSError& err, ostream& os, bool optimize=true);
+
+
+	private:
+
+	static void AddOp(vector<SVFOp>& opList, SVFOpCode code, TAPState state, unsigned int arg, unsigned long position);
+
+	Bitstream& NewBitstream(void);
+
+	void AddShift(SVFOpCode code, TAPState endState, const Bitstream& head, const Bitstream& data, const Bitstream& tail, unsigned long position);
+
+	void AddVerifiedShift(SVFOpCode code, TAPState endState, const Bitstream& head, const Bitstream& data, const Bitstream& tail,
+						const Bitstream& tdo, const Bitstream& mask, unsigned long position);
+
+	vector<SVFOp> ops;				///< operations in the order they are performed
+	vector<Bitstream> bitstreams;	///< header+data+trailer bits for each SIR and SDR
+	vector<Bitstream> spare;		///< bitstreams released by Reuse() whose storage is used for new shifts
+	unsigned long sourceLength;		///< number of characters in the SVF file
+	bool optimized;					///< true if redundant operations have been removed
+	TAPState optState;				///< TAP state the optimizer has reached
+	int optIR;						///< index of the bitstream the optimizer has in the IR, or -1 if unknown
+	unsigned long tcksSaved;		///< number of TCK pulses removed by the optimizer
+
+	TAPState endir;		///< end state for SIR commands
+	TAPState enddr;		///< end state for SDR commands
+	Bitstream hir;		///< header bits for the IR
+	Bitstream hdr;		///< header bits for the DR
+	Bitstream tir;		///< trailer bits for the IR
+	Bitstream tdr;		///< trailer bits for the DR
+	Bitstream sir;		///< last bits sent to the IR (reused if an SIR has no TDI field)
+	Bitstream sdr;		///< last bits sent to the DR (reused if an SDR has no TDI field)
+	Bitstream sirTDO;	///< bits expected from the IR
+	Bitstream sdrTDO;	///< bits expected from the DR
+	Bitstream sirMask;	///< IR bits that are compared with the expected bits
+	Bitstream sdrMask;	///< DR bits that are compared with the expected bits
+};
+
+#endif
@@ -0,0 +1,195 @@
+/*----------------------------------------------------------------------------------
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+	02111-1307, USA.
+
+	1997-2010 - X Engineering Software Systems Corp.
+----------------------------------------------------------------------------------*/
+
+
+
+#include <cstring>
+using namespace std;
+
+#include "svfread.h"
+
+
+static const unsigned int chunkSize = 65536;	// number of characters read from the stream at a time
+
+
+// Return true if a character separates the words of an SVF command.
+static inline bool IsSpace(char c)
+{
+	return c==' ' || c=='\t' || c=='\r' || c=='\n';
+}
+
+
+/// Compare an SVF word to a string.
+///\return true if the word and the string are the same.
+bool SVFWord::Is(const char* s) const
+{
+	return strncmp(ptr,s,len)==0 && s[len]==0;
+}
+
+
+/// Create an object that reads SVF commands from a stream.
+SVFReader::SVFReader(istream& s)	///< stream delivering the SVF file
+{
+	is = &s;
+	chunk = new char[chunkSize];
+	chunkLength = chunkPos = 0;
+	position = 0;
+	cmdPos = 0;
+	cmd.push_back(0);
+}
+
+
+/// Destroy the SVF reader.
+SVFReader::~SVFReader(void)
+{
+	delete [] chunk;
+}
+
+
+/// Read the next chunk of the SVF file into the chunk buffer.
+///\return true if any characters were read, false at the end of the file.
+bool SVFReader::FillChunk(void)
+{
+	if(is->eof() || is->fail())
+		return false;
+	is->read(chunk,chunkSize);
+	chunkLength = is->gcount();
+	chunkPos = 0;
+	return chunkLength > 0;
+}
+
+
+/// Get the next command from the SVF file.
+/// Comments (starting with ! or //) are removed and line breaks are turned into spaces.
+///\return true if a command was found, false if the end of the file was reached.
+bool SVFReader::NextCommand(void)
+{
+	bool inComment = false;		// true while skipping the rest of a line after a comment marker
+	bool pendingSlash = false;	// true if the last character was a '/' that may start a comment
+	bool hasText = false;		// true if the command contains something besides whitespace
+
+	cmd.clear();
+	cmdPos = 0;
+
+	while(true)
+	{
+		if(chunkPos >= chunkLength && !FillChunk())
+			break;	// end of file
+
+		char c = chunk[chunkPos++];
+		position++;
+
+		if(inComment)
+		{
+			if(c=='\n' || c=='\r' || c==0x0c)
+			{
+				inComment = false;
+				cmd.push_back(' ');
+			}
+			continue;
+		}
+
+		if(pendingSlash)
+		{
+			pendingSlash = false;
+			if(c=='/')
+			{
+				inComment = true;
+				continue;
+			}
+			cmd.push_back('/');
+			hasText = true;
+		}
+
+		switch(c)
+		{
+		case '!':
+			inComment = true;
+			break;
+		case '/':
+			pendingSlash = true;
+			break;
+		case ';':
+			cmd.push_back(0);
+			return true;
+		case '\n':
+		case '\r':
+		case 0x0c:
+			cmd.push_back(' ');
+			break;
+		default:
+			cmd.push_back(c);
+			if(!IsSpace(c))
+				hasText = true;
+			break;
+		}
+	}
+
+	// the end of the file was reached; the last command may be missing its semicolon
+	if(pendingSlash)
+	{
+		cmd.push_back('/');
+		hasText = true;
+	}
+	cmd.push_back(0);
+	return hasText;
+}
+
+
+/// Get the next word from the current SVF command.
+/// A word is either a keyword or number delimited by whitespace, or a parenthesized
+/// field (like the hex bits of a TDI field) including the parentheses.
+///\return the next word, or an empty word if there are no more words in the command.
+SVFWord SVFReader::NextWord(void)
+{
+	SVFWord word;
+	const char* s = &cmd[0];
+
+	// skip leading whitespace
+	while(s[cmdPos]!=0 && IsSpace(s[cmdPos]))
+		cmdPos++;
+
+	unsigned int start = cmdPos;
+	if(s[cmdPos] == '(')
+	{
+		// find the end of the parenthesized field
+		while(s[cmdPos]!=0 && s[cmdPos]!=')')
+			cmdPos++;
+		if(s[cmdPos] == ')')
+			cmdPos++;
+	}
+	else
+	{
+		// find the end of the keyword
+		while(s[cmdPos]!=0 && !IsSpace(s[cmdPos]) && s[cmdPos]!='(')
+			cmdPos++;
+	}
+
+	word.ptr = s + start;
+	word.len = cmdPos - start;
+	return word;
+}
+
+
+/// Get the number of characters read from the SVF file so far.
+///\return the position in the file.
+unsigned long SVFReader::GetPosition(void) const
+{
+	return position;
+}
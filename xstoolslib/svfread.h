@@ -0,0 +1,83 @@
+/*----------------------------------------------------------------------------------
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+	02111-1307, USA.
+
+	1997-2010 - X Engineering Software Systems Corp.
+----------------------------------------------------------------------------------*/
+
+
+
+#ifndef SVFREAD_H
+#define SVFREAD_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+/// A word from an SVF command.  This just points into the reader's command buffer
+/// (like a string_view) so words, and especially long hex fields, aren't copied.
+struct SVFWord
+{
+	const char* ptr;	///< first character of the word
+	unsigned int len;	///< number of characters in the word
+
+	bool IsEmpty(void) const { return len == 0; }
+	bool Is(const char* s) const;
+	string ToString(void) const { return string(ptr,len); }
+};
+
+
+/**
+Reads the commands from an SVF file one at a time.
+
+This object reads an SVF stream in fixed-size chunks and extracts one 
+semicolon-terminated command at a time, removing comments and line 
+breaks as it goes. The words of the current command are then fetched 
+with NextWord() which just returns pointers into the command buffer. 
+Each character of the file is only examined once, so the commands at the 
+start of a file can be executed before the rest of the file has been read 
+and long TDI fields don't cause repeated copying. 
+*/
+class SVFReader
+{
+	public:
+
+	SVFReader(istream& is);
+
+	~SVFReader(void);
+
+	bool NextCommand(void);
+
+	SVFWord NextWord(void);
+
+	unsigned long GetPosition(void) const;
+
+
+	private:
+
+	bool FillChunk(void);
+
+	istream* is;				///< stream delivering the SVF file
+	char* chunk;				///< buffer for the chunk of the file being scanned
+	unsigned int chunkLength;	///< number of characters in the chunk buffer
+	unsigned int chunkPos;		///< position of the next character in the chunk buffer
+	unsigned long position;		///< number of characters consumed from the stream
+	vector<char> cmd;			///< current command with comments and line breaks removed
+	unsigned int cmdPos;		///< position of the next word in the current command
+};
+
+#endif
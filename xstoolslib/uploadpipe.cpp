@@ -0,0 +1,134 @@
+#include <cassert>
+#include <string.h>
+
+#include "uploadpipe.h"
+
+
+static const unsigned int numChunks = 8;		// chunks in the ring between the port and the writer thread
+static const unsigned int chunkSize = 0x4000;	// data bytes in each chunk
+
+
+/// Create a pipe and start the thread that writes records to the stream.
+UploadPipe::UploadPipe(ostream& s,	///< stream the records are written to
+				const char* format)		///< hex file format
+	: os(s), ring(numChunks)
+{
+	hx.Setup(format);
+	for(unsigned int i=0; i<numChunks; i++)
+		ring[i].data.reserve(chunkSize);
+	fillIndex = 0;
+	writeIndex = 0;
+	numFull = 0;
+	done = false;
+	failed = false;
+	writer = thread(&UploadPipe::WriteChunks,this);
+}
+
+
+/// Write out any records that are still in the pipe and stop the writer thread.
+UploadPipe::~UploadPipe(void)
+{
+	Finish();
+}
+
+
+/// Queue a hex record to be written to the stream.
+///\return true if the stream is still good, false if writing has failed
+bool UploadPipe::Write(HexRecord& rec)	///< hex record with data from the board
+{
+	assert(rec.GetLength() <= chunkSize);
+
+	Chunk* c = &ring[fillIndex];
+	if(c->data.size()+rec.GetLength() > chunkSize)
+	{
+		if(!CommitChunk())
+			return false;
+		c = &ring[fillIndex];
+	}
+
+	c->records.push_back(make_pair((unsigned long)rec.GetAddress(),rec.GetLength()));
+	for(unsigned int i=0; i<rec.GetLength(); i++)
+		c->data.push_back(rec[i]);
+	return !failed;
+}
+
+
+/// Write the records that are still in the pipe and wait for the writer thread to end.
+///\return true if all the records were written, false if writing failed
+bool UploadPipe::Finish(void)
+{
+	if(!writer.joinable())
+		return !failed;
+
+	if(!ring[fillIndex].records.empty())
+		CommitChunk();
+
+	{
+		lock_guard<mutex> locker(lock);
+		done = true;
+	}
+	filled.notify_all();
+	writer.join();
+	os.flush();
+	return !failed && !os.fail();
+}
+
+
+/// Pass the chunk being filled to the writer thread and wait until the next chunk is free.
+///\return true if the stream is still good, false if writing has failed
+bool UploadPipe::CommitChunk(void)
+{
+	unique_lock<mutex> locker(lock);
+	numFull++;
+	fillIndex = (fillIndex+1) % numChunks;
+	filled.notify_all();
+	emptied.wait(locker,[this]{ return numFull<numChunks || failed; });
+	return !failed;
+}
+
+
+/// Format the committed chunks and write them to the stream until the pipe is finished.
+void UploadPipe::WriteChunks(void)
+{
+	unique_lock<mutex> locker(lock);
+	while(true)
+	{
+		filled.wait(locker,[this]{ return numFull>0 || done; });
+		if(numFull == 0)
+			break;	// done and nothing left to write
+
+		Chunk& c = ring[writeIndex];
+		locker.unlock();
+
+		if(hx.GetFileFormat() == BinaryFormat)
+		{ // raw data needs no formatting, so the whole chunk goes out in one write
+			if(!c.data.empty())
+				os.write((const char*)&c.data[0],c.data.size());
+			if(os.fail())
+				failed = true;
+		}
+		else
+		{
+			unsigned int offset = 0;
+			for(unsigned int r=0; r<c.records.size() && !failed; r++)
+			{
+				hx.SetAddress(c.records[r].first);
+				hx.SetLength(c.records[r].second);
+				if(c.records[r].second > 0)
+					memcpy(&hx[0],&c.data[offset],c.records[r].second);
+				offset += c.records[r].second;
+				hx.CalcCheckSum();
+				os << hx;
+				if(os.fail())
+					failed = true;
+			}
+		}
+		c.data.clear();
+		c.records.clear();
+
+		locker.lock();
+		writeIndex = (writeIndex+1) % numChunks;
+		numFull--;
+		emptied.notify_all();
+	}
+}
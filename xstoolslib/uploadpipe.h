@@ -0,0 +1,71 @@
+#ifndef UPLOADPIPE_H
+#define UPLOADPIPE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "hexrecrd.h"
+
+
+/**
+Writes uploaded hex records to a stream on a separate thread.
+
+The upload loops of the RAM and Flash ports read the board a hex record 
+at a time. Instead of formatting each record and writing it to the file 
+between port reads, they hand the records to this object. The data of 
+the records is packed into fixed-size chunks held in a small ring. A 
+writer thread formats the filled chunks and sends them to the stream 
+while the port keeps reading. Chunks of raw binary data go out 
+unformatted, in a single write each. If the writer falls behind, the 
+port waits for a free chunk, so memory use stays the same however 
+large the uploaded range is. Records come out in the order they went 
+in, with the same addresses and lengths. 
+
+*/
+class UploadPipe
+{
+	public:
+
+	UploadPipe(ostream& os, const char* format);
+
+	~UploadPipe(void);
+
+	bool Write(HexRecord& hx);
+
+	bool Finish(void);
+
+
+	private:
+
+	/// Data of consecutive hex records waiting to be written.
+	struct Chunk
+	{
+		vector<unsigned char> data;		///< data bytes of the records, one record after another
+		vector< pair<unsigned long,unsigned int> > records;	///< address and length of each record
+	};
+
+	bool CommitChunk(void);
+
+	void WriteChunks(void);
+
+	ostream& os;				///< stream the records are written to
+	HexRecord hx;				///< record the writer thread formats the data into
+	vector<Chunk> ring;			///< chunks being filled, waiting or being written
+	unsigned int fillIndex;		///< chunk being filled by the port
+	unsigned int writeIndex;	///< next chunk for the writer thread
+	unsigned int numFull;		///< chunks waiting for or being handled by the writer thread
+	bool done;					///< true when no more chunks will be committed
+	atomic<bool> failed;		///< set if the stream fails
+	mutex lock;					///< guards the ring indices and flags
+	condition_variable filled;	///< signalled when a chunk is committed or the pipe is finished
+	condition_variable emptied;	///< signalled when the writer thread frees a chunk
+	thread writer;				///< thread that formats and writes the chunks
+};
+
+#endif
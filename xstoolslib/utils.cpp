@@ -37,6 +37,7 @@ using namespace std;
 #include "Markup.h"
 #include "usbjtag.h"
 #include "utils.h"
+#include "delaytmr.h"
 #include "xserror.h"
 #include "xsallbrds.h"
 #include "usbcmd.h"
@@ -194,59 +195,14 @@ bool ScanForField(istream& is,	///< stream whose contents will be searched
 }
 
 
-#pragma optimize( "", off ) // turn off optimization so timing loops don't get removed
-
-/// Delay for a given number of microseconds or milliseconds.
-void InsertDelay(unsigned long d, ///< number of microseconds or milliseconds to delay
-				unsigned int time_units) ///< time units, either MICROSECONDS or MILLISECONDS
+/// Delay for a given number of nanoseconds, microseconds or milliseconds.
+/// The delay is timed against the monotonic system clock (see DelayTimer).
+void InsertDelay(unsigned long d, ///< number of nanoseconds, microseconds or milliseconds to delay
+				unsigned int time_units) ///< time units, either NANOSECONDS, MICROSECONDS or MILLISECONDS
 {
-	static long loopsPerMillisecond = -1;
-	
-	if(loopsPerMillisecond < 0)
-	{ // determine the timing of the computer if we haven't already done so
-		long unsigned iterations = 10000000;
-		clock_t start, finish;
-		do
-		{
-		start = clock();	// get starting time
-		assert(start>=0);
-		for(long i = iterations; i>0L; i--)
-			;	// do a whole bunch of empty loops
-		finish = clock();	// get ending time
-		assert(finish>0);
-		iterations *= 2;	// double iterations for next try if needed
-		} while ((finish-start)<10);	// keep going until we have enough precision
-		// compute the number of empty loops per millisecond
-		loopsPerMillisecond = ((iterations/(2*1000))*CLOCKS_PER_SEC)/(finish-start);
-		assert(loopsPerMillisecond>1000);	// we need enough precision
-		DEBUG_STMT("finish = " << finish << "   start = " << start)
-		DEBUG_STMT("loops per ms = " << loopsPerMillisecond)
-	}
-	
-	if(time_units==MICROSECONDS && d>10000)
-	{
-		time_units = MILLISECONDS;
-		d /= 1000;
-	}
-	if(time_units == MILLISECONDS)
-	{	// doing millisecond timing here
-		long s = clock();
-		assert(s>0);	// clock() returns -1 if there is an error
-		long t = s + (d * CLOCKS_PER_SEC)/ 1000;
-		if(t==s) t++;	// must wait at least 1 clock tick
-		while(clock()<t)
-			;
-	}
-	else if(time_units == MICROSECONDS)
-	{	// doing microsecond timing here
-		for(long loops = (loopsPerMillisecond*d)/1000; loops>0; loops--)
-			;
-	}
-	else
-		;
+	DelayTimer::Delay(d,time_units);
 }
 
-#pragma optimize( "", on )
 
 /// Get the directory where the XSTOOLs store temporary data files.
 ///\return path to XSTOOLs data directory if found; NULL otherwise
@@ -651,22 +607,21 @@ const unsigned char reverseByteBits[] = {
 
 /// Combine hex data bytes to form a word of data depending upon big/little-byte/bit ordering.
 ///\return the hex data as an unsigned int
-unsigned int Hex2Data(HexRecord& hx, ///< hex record containing hex data bytes 
-				int start, ///< index of starting position within the hex record
+unsigned int Hex2Data(const unsigned char* bytes, ///< hex data bytes
 				int numBytes, ///< number of bytes in hex representation for data
 				bool bigEndianBytes, ///< true if data should be stored with most-significant byte at lower address
 				bool bigEndianBits) ///< true if data should be stored with most-significant bit in bit position 0 (right-most)
 {
 	// If translating big-endian hex into data, start at lower address and work toward higher address.
 	// Do the opposite if hex is stored in little-endian byte order.
-	int j     = bigEndianBytes ? 0        : numBytes-1; // starting byte position within hex record
-	int j_end = bigEndianBytes ? numBytes : -1; // ending position within hex record
+	int j     = bigEndianBytes ? 0        : numBytes-1; // starting byte position within hex data
+	int j_end = bigEndianBytes ? numBytes : -1; // ending position within hex data
 	int j_inc = bigEndianBytes ? 1        : -1; // direction from start to end
 	unsigned int data = 0;
 	for( ; j!=j_end; j+=j_inc)
 	{
 		// process hex from most-significant byte to least-significant byte
-		unsigned int hx_data = hx[start+j] & 0xFF;
+		unsigned int hx_data = bytes[j];
 		// reverse the bits within each hex byte if it is in big-endian bit order
 		if(bigEndianBits)
 			hx_data = reverseByteBits[hx_data];
@@ -676,6 +631,18 @@ unsigned int Hex2Data(HexRecord& hx, ///< hex record containing hex data bytes
 }
 
 
+/// Combine the data bytes of a hex record to form a word of data depending upon big/little-byte/bit ordering.
+///\return the hex data as an unsigned int
+unsigned int Hex2Data(HexRecord& hx, ///< hex record containing hex data bytes 
+				int start, ///< index of starting position within the hex record
+				int numBytes, ///< number of bytes in hex representation for data
+				bool bigEndianBytes, ///< true if data should be stored with most-significant byte at lower address
+				bool bigEndianBits) ///< true if data should be stored with most-significant bit in bit position 0 (right-most)
+{
+	return Hex2Data(&hx[start],numBytes,bigEndianBytes,bigEndianBits);
+}
+
+
 /// Split-apart a word of data into hex data bytes depending upon big/little-byte/bit ordering.
 void Data2Hex(unsigned int data,  ///< data to be rearranged (assumes bytes are stored big-endian and bits are stored little-endian)
 				HexRecord& hx, ///< hex record to store hex representation of data
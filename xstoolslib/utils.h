@@ -55,6 +55,7 @@ const char* FindXSTOOLSDataDir(void);
 const char* FindXSTOOLSBinDir(void);
 int GetXSBoardInfo(XSBoardInfo** bInfo);
 XSBoard* NewXSBoard(const char* boardModelName, PortType portType);
+unsigned int Hex2Data(const unsigned char* bytes, int numBytes, bool bigEndianBytes, bool bigEndianBits);
 unsigned int Hex2Data(HexRecord& hx, int start, int numBytes, bool bigEndianBytes, bool bigEndianBits);
 void Data2Hex(unsigned int data, HexRecord& hx, int start, int numBytes, bool bigEndianBytes, bool bigEndianBits);
 unsigned int RearrangeData(unsigned int data, unsigned int numBits, bool bigEndianBytes, bool bigEndianBits);
@@ -25,6 +25,7 @@
 #include <sstream>
 #include <ctime>
 #include <string>
+#include <vector>
 
 #include <string.h>
 
@@ -38,6 +39,9 @@ using namespace std;
 #include "xc3sprt.h"
 
 
+static const unsigned long progressChunkSize = 16384;	// bytes downloaded between progress reports and cancel checks
+
+
 /// Instantiate an XC3SPort object on a given parallel port.
 XC3SPort::XC3SPort(void)
 {
@@ -160,9 +164,7 @@ void XC3SPort::ConfigureFPGA(unsigned char b)	///< configuration byte from FPGA
     {
         // fast parallel configuration
 		// reverse the bits of the configuration byte
-		unsigned char rev_b;
-		for(int i=0; i<8; i++)
-			rev_b = (rev_b<<1) | ((b>>i) & 0x1);
+		unsigned char rev_b = reverseByteBits[b];
 		
 		// now send it to the Spartan3 as two nybble-wide chunks
 		Out((rev_b>>4)&0xF,posDLO,posDHI);	// send upper nybble
@@ -185,6 +187,56 @@ void XC3SPort::ConfigureFPGA(unsigned char b)	///< configuration byte from FPGA
 }
 
 
+/// Send out a block of configuration bytes.
+/// In fast mode with the CCLK and data pins in the same parallel port register, the register
+/// values for the upper and lower nybble of every byte value are looked up in a table built
+/// before the download starts, and a register is only written when its value changes.
+void XC3SPort::ConfigureFPGA(const unsigned char* bytes,	///< configuration bytes from FPGA bitstream
+							unsigned long numBytes)			///< number of bytes to send
+{
+	const unsigned short reg = posCCLK / 8;	// register holding CCLK and the data pins
+
+	if(!fastDownload || posDLO/8 != reg || posDHI/8 != reg)
+	{
+		for(unsigned long i=0; i<numBytes; i++)
+			ConfigureFPGA(bytes[i]);
+		return;
+	}
+
+	SetCCLK(0);	// quiescent state of CCLK is zero
+
+	// register values indexed by [byte][step]: upper nybble with CCLK low, then CCLK high,
+	// then lower nybble with CCLK still high, then CCLK low
+	const unsigned int mask = (((1U<<(posDHI-posDLO+1))-1) << posDLO) | (1U<<posCCLK);
+	const unsigned int cclk = 1U << posCCLK;
+	unsigned char table[256][4];
+	for(unsigned int b=0; b<256; b++)
+	{
+		unsigned int hi = ((reverseByteBits[b]>>4) & 0xF) << posDLO;
+		unsigned int lo = (reverseByteBits[b] & 0xF) << posDLO;
+		table[b][0] = PinPattern(reg,mask,hi);
+		table[b][1] = PinPattern(reg,mask,hi | cclk);
+		table[b][2] = PinPattern(reg,mask,lo | cclk);
+		table[b][3] = PinPattern(reg,mask,lo);
+	}
+
+	unsigned char last = PinPattern(reg,0,0);	// current contents of the register
+	for(unsigned long i=0; i<numBytes; i++)
+	{
+		const unsigned char* steps = table[bytes[i]];
+		for(unsigned int s=0; s<4; s++)
+		{
+			// the data doesn't change between steps when the nybbles are the same
+			if(steps[s] != last)
+			{
+				last = steps[s];
+				OutRaw(reg,last);
+			}
+		}
+	}
+}
+
+
 static const int BitstreamFieldType = 0x65;	// field type for the bitstream data
 
 /// Process a stream and send the configuration bitstream to the board.
@@ -229,28 +281,28 @@ bool XC3SPort::ConfigureFPGA(istream& is, bool *UserCancelled)	///< stream that
                 PulsePROG();					// pulse the PROGRAM pin to start the configuration of the FPGA
                 InsertDelay(30,MILLISECONDS);	// insert delay after PROGRAM pin goes high
 
+                // read the whole configuration field and send it to the board a chunk at a time
+                streampos fieldStart = is.tellg();
+                vector<unsigned char> bytes(fieldLength+1);
+                is.read((char*) &bytes[0], fieldLength);
+                unsigned long numRead = is.gcount();
+                assert(numRead == fieldLength);	// should not hit end-of-file
+
                 i = 0;
-                while (!*UserCancelled && (i < fieldLength))
+                while (!*UserCancelled && (i < numRead))
                 {
-                    // read the bytes and send the config. bits to the board
-                    unsigned char byte;
-
-                    is.read((char*) &byte, 1);
-                    assert(0 == is.eof());	// should not hit end-of-file
-
-                    ConfigureFPGA(byte);
+                    unsigned long n = numRead - i;
+                    if (n > progressChunkSize)
+                        n = progressChunkSize;
+                    ConfigureFPGA(&bytes[i], n);
+                    i += n;
 
                     if (NULL != progressGauge)
                     {
-                        *UserCancelled = progressGauge->UserHasCancelled();
-
                         // output some feedback as the configuration proceeds
-                        if (0 == (i % 1000))
-                        {
-                            progressGauge->Report(is.tellg());
-                        }
+                        progressGauge->Report((long)fieldStart + i);
+                        *UserCancelled = progressGauge->UserHasCancelled();
                     }
-                    i++;
                 }
                 if (!*UserCancelled)
                 {
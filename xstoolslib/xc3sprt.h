@@ -38,6 +38,11 @@ Spartan3 FPGA in SelectMap configuration mode, or slow mode where each
 byte is serially transmitted through a single pin of the parallel port 
 into the FPGA in slave-serial configuration mode.
 
+The bitstream field is read into memory in one piece. In fast mode, the 
+parallel port register values for both nybbles of every possible byte 
+are computed before the download starts, so each byte only takes the 
+register writes that actually change a pin. 
+
 */
 class XC3SPort : public CnfgPort
 {
@@ -63,6 +68,8 @@ class XC3SPort : public CnfgPort
 
 	void ConfigureFPGA(unsigned char b);
 
+	void ConfigureFPGA(const unsigned char* bytes, unsigned long numBytes);
+
     bool ConfigureFPGA(istream& is, bool *UserCancelled);
 
     bool ConfigureFPGA(const char *fileName, bool *UserCancelled);
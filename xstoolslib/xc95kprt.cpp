@@ -29,6 +29,7 @@
 using namespace std;
 
 #include "utils.h"
+#include "delaytmr.h"
 #include "hex.h"
 #include "bitstrm.h"
 #include "xc95kprt.h"
@@ -136,7 +137,19 @@ bool XC95KPort::ConfigureCPLD(unsigned char b)	///< configuration byte
 ///\return true if the operation was a success, false otherwise
 bool XC95KPort::ConfigureCPLD(istream& is, const char *fileName, bool *UserCancelled)
 {
-    return DownloadSVF(is, fileName, UserCancelled);
+    bool status;
+    unsigned long writes, suppressed, reads;
+
+    ResetIOCounts();
+    ResetNumReadsAvoided();
+    DelayTimer::ResetStats();
+    status = DownloadSVF(is, fileName, UserCancelled);
+
+    GetIOCounts(writes, suppressed, reads);
+    DEBUG_STMT("Port writes = " << writes << ", writes suppressed = " << suppressed
+               << ", reads = " << reads << ", reads avoided = " << GetNumReadsAvoided())
+    DEBUG_STMT("Delays:\n" << DelayTimer::GetStats())
+    return status;
 }
 
 
@@ -19,6 +19,7 @@
 
 
 #include <ctime>
+#include <sstream>
 #include <string>
 #include <string.h>
 
@@ -317,13 +318,14 @@ bool XSA3SBoard::DownloadRAM(const char *fileName, bool bigEndianBytes,
     bool status;
 
     status = false;
+    transferSummary = "";
 	XSError& errMsg = fpga.GetErr(); // setup error channel
 
 	// check the file suffix to see if it is appropriate for downloading to RAM
 	string suffix = GetSuffix(fileName);
-    if (suffix!="HEX" && suffix!="EXO" && suffix!="XES" && suffix!="MCS")
+    if (suffix!="HEX" && suffix!="EXO" && suffix!="XES" && suffix!="MCS" && suffix!="BIN")
 	{
-		errMsg.SimpleMsg(XSErrorMajor,"Only .HEX, .MCS, .EXO or .XES files can be downloaded into the RAM on the XSA-3S Board!!\n");
+		errMsg.SimpleMsg(XSErrorMajor,"Only .HEX, .MCS, .EXO, .XES or .BIN files can be downloaded into the RAM on the XSA-3S Board!!\n");
 	}
     else
     {
@@ -369,6 +371,8 @@ bool XSA3SBoard::UploadRAM(const char *fileName, const char* format,
 {
     bool status;
 
+    transferSummary = "";
+
     // setup error channel
     XSError& errMsg = fpga.GetErr();
 
@@ -406,6 +410,12 @@ bool XSA3SBoard::UploadRAM(const char *fileName, const char* format,
             {
                 errMsg.SimpleMsg(XSErrorMajor,"Error uploading from RAM!!\n");
             }
+            else
+            {
+                ostringstream summary;
+                summary << "RAM upload: " << (unsigned long)(hiAddr - loAddr + 1) << " bytes at " << (unsigned long)ram.GetUploadRate() << " bytes/s";
+                transferSummary = summary.str();
+            }
         }
     }
     return status;
@@ -498,14 +508,15 @@ bool XSA3SBoard::DownloadFlash(const char *fileName, bool bigEndianBytes,
     bool status;
 
     status = false;
+    transferSummary = "";
     string chipID;
     XSError& errMsg = fpga.GetErr(); // setup error channel
 
 	// check the file suffix to see if it is appropriate for downloading to RAM
 	string suffix = GetSuffix(fileName);
-    if (suffix!="HEX" && suffix!="EXO" && suffix!="XES" && suffix!="MCS")
+    if (suffix!="HEX" && suffix!="EXO" && suffix!="XES" && suffix!="MCS" && suffix!="BIN")
 	{
-        errMsg.SimpleMsg(XSErrorMajor,"Only .HEX, .MCS, .EXO or .HEX files can be downloaded into the Flash on the XSA-3S Board!!\n");
+        errMsg.SimpleMsg(XSErrorMajor,"Only .HEX, .MCS, .EXO, .XES or .BIN files can be downloaded into the Flash on the XSA-3S Board!!\n");
 	}
     else
     {
@@ -556,13 +567,18 @@ bool XSA3SBoard::DownloadFlash(const char *fileName, bool bigEndianBytes,
                         flash.Out(0xFF,0,7);
 
                         // download data into the Flash
-                        status = !flash.DownloadFlash(fileName,bigEndianBytes,bigEndianBits,doStart);
+                        status = flash.DownloadFlash(fileName,bigEndianBytes,bigEndianBits,doStart);
                         if (!status)
                         {
                             errMsg.SimpleMsg(XSErrorMajor,"Error programming the Flash on the XSA-3S Board!\n");
                         }
                         else
                         {
+                            ostringstream summary;
+                            summary << "Flash download: " << flash.GetBytesProgrammed() << " bytes programmed, "
+                                << flash.GetBytesSkipped() << " bytes skipped, " << (unsigned long)flash.GetDownloadRate() << " bytes/s";
+                            transferSummary = summary.str();
+
                             // if this is the last file to be downloaded to Flash, then reprogram the CPLD with a circuit
                             // that will make the CPLD load the FPGA with the contents of the Flash upon power-up.
                             if (doEnd)
@@ -594,6 +610,7 @@ bool XSA3SBoard::UploadFlash(const char *fileName, const char* format,
     XSError& errMsg = fpga.GetErr(); // setup error channel
 
     status = false;
+    transferSummary = "";
 
 	// get the name of the file that contains a bitstream that will configure the FPGA to provide an interface
 	// between the parallel port and the Flash.
@@ -650,6 +667,10 @@ bool XSA3SBoard::UploadFlash(const char *fileName, const char* format,
                 }
                 else
                 {
+                    ostringstream summary;
+                    summary << "Flash upload: " << (unsigned long)(hiAddr - loAddr + 1) << " bytes at " << (unsigned long)flash.GetUploadRate() << " bytes/s";
+                    transferSummary = summary.str();
+
                     // you can only upload a single file from Flash, so reprogram the CPLD with a circuit
                     // that will make the CPLD load the FPGA with the contents of the Flash upon power-up.
                     // (We are assuming this was the circuit programmed into the CPLD before uploading from the Flash.)
@@ -1004,3 +1025,10 @@ bool XSA3SBoard::UploadRAMToIntArray(unsigned *intArray, unsigned address, unsig
 {
 	return false; // This method is not implemented.
 }
+
+
+// Look at xsboard.h for a description of the interface.
+string XSA3SBoard::GetTransferSummary(void)
+{
+	return transferSummary;
+}
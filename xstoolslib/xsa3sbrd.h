@@ -89,6 +89,8 @@ class XSA3SBoard : public XSBoard
 
 	bool UploadRAMToIntArray(unsigned *intArray, unsigned address, unsigned numInts);			
 
+	string GetTransferSummary(void);
+
 	
 	private:
 
@@ -103,6 +105,8 @@ class XSA3SBoard : public XSBoard
 	RAMPort ram;			///< SDRAM
 	AM29FPort flash;		///< Spansion Flash
 
+	string transferSummary;	///< description of the last RAM or Flash transfer
+
 private:
     bool DumpUserCode(const char *Prompt, string usercode);
 
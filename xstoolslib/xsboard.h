@@ -242,6 +242,14 @@ class XSBoard
 		unsigned numInts)		///< number of data values to upload from the XS Board RAM
 		= 0;			
 
+	/// Describe the last RAM or Flash upload or download.
+	/// Boards that don't measure their transfers return an empty string.
+	///\return the amount of data transferred and the transfer rate.
+	virtual string GetTransferSummary(void)
+	{
+		return "";
+	}
+
 	
 	protected:
 
@@ -28,6 +28,7 @@
 using namespace std;
 
 #include "progress.h"
+#include "heximage.h"
 #include "jtaginstr.h"
 #include "lptjtag.h"
 #include "usbjtag.h"
@@ -565,7 +566,7 @@ bool XSJTAGBoard::UploadRAM(const char *fileName, const char* format, unsigned i
 	}
 
 	// otherwise open the hex file	
-    ofstream os(fileName);
+    ofstream os(fileName, IsBinaryFormat(format) ? ios::out|ios::binary : ios::out);
 	if(os.fail() || os.eof()!=0)
 	{ // error - couldn't open hex file
 		brdErr->SetSeverity(XSErrorMajor);
@@ -741,6 +742,10 @@ bool XSJTAGBoard::UploadRAM(const char *fileName, const char* format, unsigned i
 
 	os.close();  // close-up the hex file
 
+	// record where raw data came from so it can be downloaded again
+	if(!HexImage::UpdateInfo(fileName,format,loAddr,hiAddr-loAddr+1,*brdErr))
+		return false;
+
 	return true;
 }
 
@@ -1139,7 +1144,7 @@ bool XSJTAGBoard::UploadFlash(const char *fileName, const char* format, unsigned
 	}
 
 	// otherwise open the hex file	
-    ofstream os(fileName);
+    ofstream os(fileName, IsBinaryFormat(format) ? ios::out|ios::binary : ios::out);
 	if(os.fail() || os.eof()!=0)
 	{ // error - couldn't open hex file
 		brdErr->SetSeverity(XSErrorMajor);
@@ -1300,6 +1305,10 @@ bool XSJTAGBoard::UploadFlash(const char *fileName, const char* format, unsigned
 
 	os.close();  // close-up the hex file
 
+	// record where raw data came from so it can be downloaded again
+	if(!HexImage::UpdateInfo(fileName,format,loAddr,hiAddr-loAddr+1,*brdErr))
+		return false;
+
 	// you can only upload a single file from Flash, so reprogram the CPLD with a circuit
 	// that will make the CPLD load the FPGA with the contents of the Flash upon power-up.
 	// (We are assuming this was the circuit programmed into the CPLD before uploading from the Flash.)